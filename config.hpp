@@ -1,6 +1,7 @@
 #ifndef config_hpp
 #define config_hpp
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -28,47 +29,307 @@ static const bool twoBars = true;
  */
 static const std::string botTopDelimiter(";");
 
+/** \brief Run all modules from a single event loop thread
+ *
+ * If `true`, all modules are driven from one thread using `epoll`, `timerfd`, and `signalfd`.
+ * If `false`, each module runs in its own thread.
+ * The event loop uses less memory and causes fewer context switches, but while one module runs, no other module (and no real-time signal) is served.
+ * External and streaming commands run in the background and never hold up the loop. Built-in modules only read kernel files,
+ * and the disk module measures file systems from a few worker threads, so a file system that does not respond only delays the disk output. Use separate threads if a module you add can block.
+ */
+static const bool useEventLoop = true;
+
+/** \brief Render coalescing window
+ *
+ * Time (in milliseconds) to wait after a module update before printing to the bar.
+ * Updates from other modules that arrive within this window are printed together.
+ * Set to 0 to print after every update.
+ */
+static const uint32_t coalesceWindow = 10;
+
+/** \brief Render statistics report interval
+ *
+ * Interval (in seconds) between reports of the number of module updates and bar renders printed to the standard error.
+ * Set to 0 to disable the report.
+ */
+static const uint32_t renderReportInterval = 0;
+
+/** \brief Default external command timeout
+ *
+ * External commands that run longer than this (in seconds) are terminated and their previous output is shown with the timeout marker.
+ * Set to 0 for no limit. Can be changed for each module with the `timeout=` keyword (see below).
+ */
+static const uint32_t externTimeout = 5;
+
+/** \brief Timeout marker
+ *
+ * Appended to the previous output of an external command that timed out.
+ */
+static const std::string externTimeoutMarker(" \uf252");
+
 /** List of top modules
  *
  * Names of modules for the top bar.
  * The necessary module information is:
  * - module name (one of the provided internal objects, the path to the relevant script, or a shell command)
- * - internal/external keyword
+ * - internal/external/stream keyword. A stream command is started once and kept running; each line it prints replaces the module output.
+ *   For stream commands the refresh interval sets how often a command that exited is restarted.
  * - refresh interval (in seconds; 0 means update only on receiving a real-time signal)
  * - `SIGRTMIN` signal ID, must be between 0 and 30.
  *   If the refresh interval is not zero, a real-time signal ca still be used to trigger the module before the interval expires.
+ * - optional keywords:
+ *   + `align` makes refreshes happen at multiples of the interval in local time (e.g., at the top of every minute for a 60 second interval)
+ *     instead of at multiples of the interval since the start of the program.
+ *   + `timeout=<seconds>` sets the maximal run time of an external command, overriding `externTimeout` (0 means no limit).
  */
 static const std::vector< std::vector<std::string> > topModuleList = {
-	{"~/.scripts/checkMail",    "external", "0",   "8"},
-	{"~/.scripts/pacupdate",    "external", "300", "9"},
+	{"ModuleMail",              "internal", "0",   "8"},
+	{"ModulePacman",            "internal", "0",   "9"},
 	{"~/.scripts/getMicVolume", "external", "10",  "12"},
 	{"~/.scripts/getVolume",    "external", "10",  "10"},
-	{"~/.scripts/wifiSignal",   "external", "10",  "11"},
+	{"ModuleWifi",              "internal", "10",  "11"},
 };
 
 /** List of bottom modules
  *
  * Names of modules for the bottom bar.
  * See the top bar info for instructions.
+ * `ModuleBattery` also refreshes whenever the kernel reports a power supply change, so its interval is only a fallback.
+ * `ModuleRAID` refreshes whenever the kernel reports a software RAID change, so its interval can be 0.
  */
 static const std::vector< std::vector<std::string> > bottomModuleList = {
-	{"ModuleDate",          "internal", "60",  "1"},
-	{"ModuleBattery",       "internal", "5",   "2"},
+	{"ModuleDate",          "internal", "60",  "1", "align"},
+	{"ModuleBattery",       "internal", "300", "2"},
 	{"ModuleCPU",           "internal", "2",   "3"},
-	{"~/.scripts/gpuStats", "external", "10",   "4"},
+	{"ModuleGPU",           "internal", "10",  "4"},
 	{"ModuleRAM",           "internal", "2",   "5"},
+	{"ModuleNet",           "internal", "2",   "14"},
 	{"ModuleDisk",          "internal", "10",  "6"},
-	{"~/.scripts/wanIP",    "external", "300", "7"},
+	{"ModuleRAID",          "internal", "0",   "13"},
+	{"~/.scripts/wanIP",    "external", "300", "7", "timeout=15"},
 };
 
 /** \brief Date format for the internal date/time module */
 static const std::string dateFormat("%a %b %e %H:%M %Z");
 
+/** \brief Mail directory
+ *
+ * Directory searched for maildir folders by the new mail module (`ModuleMail`). A leading `~/` is replaced with the home directory.
+ */
+static const std::string mailRoot("~/.mail");
+
+/** \brief Mail folder name
+ *
+ * Name of the maildir folders whose new messages are counted.
+ */
+static const std::string mailFolder("Inbox");
+
+/** \brief New mail glyph
+ *
+ * Appended to the number of new messages.
+ */
+static const std::string mailGlyph(" \uf430");
+
+/** \brief Package database directory
+ *
+ * `pacman` database directory used by the update counter module (`ModulePacman`).
+ */
+static const std::string pacmanDBRoot("/var/lib/pacman");
+
+/** \brief Package repositories
+ *
+ * Sync repositories in the order they appear in `pacman.conf`. If empty, all sync databases are used in name order.
+ */
+static const std::vector<std::string> pacmanRepositories{"core", "extra", "multilib"};
+
+/** \brief Ignored packages
+ *
+ * Packages that are not counted by the update counter module, normally the `IgnorePkg` list from `pacman.conf`.
+ */
+static const std::vector<std::string> pacmanIgnored{};
+
+/** \brief Update glyph
+ *
+ * Appended to the number of packages that can be updated.
+ */
+static const std::string pacmanGlyph(" \uf487");
+
+/** \brief Power supply class directory
+ *
+ * Searched for batteries and UPS devices by the battery module (`ModuleBattery`).
+ */
+static const std::string powerSupplyRoot("/sys/class/power_supply");
+
+/** \brief Battery glyphs
+ *
+ * Used by the battery module (`ModuleBattery`). The rows are for a discharging battery, an idle battery (on external power, but not charging), and a charging battery.
+ * The columns are 5% steps of charge: the first is for less than 5%, the second for 5 to 9%, and so on; the last is for a full battery.
+ */
+static constexpr const char *batteryGlyphs[3][21] = {
+	{
+		"\uf58d", "\uf579", "\uf57a", "\uf57a", "\uf57b", "\uf57b", "\uf57c",
+		"\uf57c", "\uf57d", "\uf57d", "\uf57e", "\uf57e", "\uf57f", "\uf57f",
+		"\uf580", "\uf580", "\uf581", "\uf581", "\uf578", "\uf578", "\uf578"
+	},
+	{
+		"\uf58d", "\uf579", "\uf57a", "\uf57a", "\uf57b", "\uf57b", "\uf57c",
+		"\uf57c", "\uf57d", "\uf57d", "\uf57e", "\uf57e", "\uf57f", "\uf57f",
+		"\uf580", "\uf580", "\uf581", "\uf581", "\uf578", "\uf578", "\uf583"
+	},
+	{
+		"\uf58d", "\uf585", "\uf585", "\uf585", "\uf586", "\uf586", "\uf587",
+		"\uf587", "\uf588", "\uf588", "\uf588", "\uf588", "\uf589", "\uf589",
+		"\uf589", "\uf589", "\uf58a", "\uf58a", "\uf578", "\uf578", "\uf583"
+	}
+};
+
+/** \brief hwmon class directory
+ *
+ * Searched for temperature sensors by the CPU module (`ModuleCPU`).
+ */
+static const std::string hwmonRoot("/sys/class/hwmon");
+
+/** \brief CPU temperature sensors
+ *
+ * Used by the CPU module (`ModuleCPU`). Each sensor is either a `hwmon` chip name (all sensors of the chip) or a chip name and a sensor label separated by a slash.
+ * Sensors without a label are named after their attribute (e.g., `temp1`). Run `sensors` from lm_sensors to see the chip names and labels. If empty, every sensor is used.
+ */
+static const std::vector<std::string> cpuSensors{"k10temp/Tctl", "zenpower/Tdie", "coretemp/Package id 0", "cpu_thermal"};
+
+/** \brief CPU temperature summary
+ *
+ * How the CPU module combines the readings of the sensors in `cpuSensors`: `first` shows the first sensor in the list that is present, `max` the hottest sensor, and `average` the mean of all of them.
+ */
+static const std::string cpuSensorSummary("first");
+
+/** \brief CPU temperature hysteresis
+ *
+ * Degrees Celsius the temperature must drop below a threshold before the CPU module switches to a cooler thermometer glyph.
+ */
+static const uint32_t cpuTempHysteresis = 3;
+
+/** \brief DRM class directory
+ *
+ * Searched for the GPU by the GPU module (`ModuleGPU`).
+ */
+static const std::string drmRoot("/sys/class/drm");
+
+/** \brief GPU card
+ *
+ * DRM card (e.g., `card1`) displayed by the GPU module. If empty, the first card with an `amdgpu` or `i915` driver is used.
+ */
+static const std::string gpuCard("");
+
+/** \brief GPU fallback command
+ *
+ * Run by the GPU module when there is no card with a `sysfs` interface. The command is kept running and must print a line with the load, temperature, and (optionally) frequency,
+ * separated by commas, every time it samples the GPU. Leave empty to display nothing on such systems.
+ */
+static const std::string gpuCommand("nvidia-smi --id=0 --query-gpu=utilization.gpu,temperature.gpu,clocks.gr --format=csv,noheader,nounits --loop=10");
+
+/** \brief GPU temperature hysteresis
+ *
+ * Degrees Celsius the temperature must drop below a threshold before the GPU module switches to a cooler thermometer glyph.
+ */
+static const uint32_t gpuTempHysteresis = 3;
+
+/** \brief Number of the busiest CPU cores to display
+ *
+ * Used by the per-core CPU module (`ModuleCPUCores`). If 0, the load of every core is shown as a heat map of block characters.
+ * Otherwise, this many of the busiest cores are listed with their load.
+ */
+static const uint32_t cpuTopCores = 0;
+
+/** \brief Memory fields to display
+ *
+ * Used by the memory module (`ModuleRAM`). Each field is a `/proc/meminfo` key followed by the label to display in front of its value.
+ * Useful keys include `MemAvailable`, `SwapFree`, `Dirty`, `Cached`, and `Zswapped`. Values of at least 1 GiB are shown in GiB, smaller ones in MiB.
+ * Fields are separated by a space.
+ */
+static const std::vector< std::vector<std::string> > memFields{
+	{"MemAvailable", "\uf85a "},
+};
+
+/** \brief RAID progress refresh interval
+ *
+ * Refresh interval (in seconds) of the RAID module (`ModuleRAID`) while an array is being synchronized.
+ */
+static const uint32_t raidProgressInterval = 10;
+
+/** \brief Wireless interface
+ *
+ * Used by the wireless module (`ModuleWifi`). If empty, the first interface in `/proc/net/wireless` is used.
+ */
+static const std::string wifiInterface("");
+
+/** \brief Wireless signal level thresholds
+ *
+ * Signal levels in dBm, from strongest to weakest, that separate the signal bars in `wifiBars`.
+ */
+static constexpr int32_t wifiLevels[3] = {-50, -67, -80};
+
+/** \brief Wireless signal bars
+ *
+ * Displayed for signals stronger than the first threshold in `wifiLevels`, between consecutive thresholds, and weaker than the last one.
+ */
+static constexpr const char *wifiBars[4] = {"\u2582\u2584\u2586\u2588", "\u2582\u2584\u2586 ", "\u2582\u2584  ", "\u2582   "};
+
+/** \brief Wireless disconnected marker
+ *
+ * Displayed by the wireless module when there is no connection.
+ */
+static const std::string wifiDisconnected("\ufaa9");
+
+/** \brief Network class directory
+ *
+ * Used by the network throughput module (`ModuleNet`) to tell physical interfaces from virtual ones.
+ */
+static const std::string netClassRoot("/sys/class/net");
+
+/** \brief Network interfaces to monitor
+ *
+ * Used by the network throughput module (`ModuleNet`). If empty, the traffic of all physical interfaces is added up.
+ * Virtual interfaces (loopback, bridges such as `docker0`, `veth` pairs, and tunnels such as `wg0`) are left out, because their traffic is also counted on a physical interface.
+ */
+static const std::vector<std::string> netInterfaces{};
+
 /** \brief List of file systems to monitor
  *
  * File systems to monitor for available space using the built-in disk space module.
  */
 static const std::vector<std::string> fsNames{"/home", "/home/tonyg/extra"};
 
+/** \brief File system types to monitor
+ *
+ * Every mounted file system of these types (e.g., `nfs4`) is monitored in addition to the ones listed in `fsNames`.
+ * The list follows the mount table as file systems are mounted and unmounted.
+ */
+static const std::vector<std::string> fsTypes{};
+
+/** \brief File system timeout
+ *
+ * Time (in milliseconds) the disk space module waits for the file systems to respond before publishing the last values of the ones that have not.
+ * File systems are measured concurrently, so this is the longest the output takes regardless of the number of file systems.
+ */
+static const uint32_t fsTimeout = 1000;
+
+/** \brief Stale file system marker
+ *
+ * Appended to the last measured value of a file system that did not respond before the timeout.
+ */
+static const std::string fsStaleMarker(" \uf252");
+
+/** \brief Unmounted file system marker
+ *
+ * Displayed instead of the free space of a listed file system that is not mounted.
+ */
+static const std::string fsUnmountedMarker("\uf127");
+
+/** \brief Read-only file system marker
+ *
+ * Appended to the free space of a file system that is mounted read-only.
+ */
+static const std::string fsReadOnlyMarker(" \uf023");
+
 #endif // config_hpp
 
@@ -26,7 +26,6 @@
  * Can use two bars (bottom and top) if dwm is patched with `dwm-extrabar`.
  *
  */
-#include <X11/Xlib.h>
 #include <bits/stdint-intn.h>
 #include <csignal>
 #include <cstddef>
@@ -35,10 +34,19 @@
 #include <vector>
 #include <thread>
 #include <mutex>
-#include <condition_variable>
 #include <chrono>
+#include <memory>
+#include <functional>
+#include <stdexcept>
+
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
 
 #include "modules.hpp"
+#include "eventloop.hpp"
+#include "renderer.hpp"
 // modify this file to configure what modules go where
 #include "config.hpp"
 
@@ -47,184 +55,233 @@ using std::stoi;
 using std::vector;
 using std::thread;
 using std::this_thread::sleep_for;
-using std::mutex;
-using std::unique_lock;
-using std::condition_variable;
 using std::chrono::seconds;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
 using std::cerr;
+using std::unique_ptr;
 
 using namespace DWMBspace;
 
 /** \brief Number of possible real-time signals */
-static const int sigRTNUM = 30;
-/** \brief Condition variables that will respond to real-time signals */
-static vector<condition_variable> signalCondition(sigRTNUM);
+static const int sigRTNUM = 31;
+/** \brief Event file descriptors that will respond to real-time signals
+ *
+ * One `eventfd` for each module that uses the signal, so that every module wakes up. Only used if each module runs in its own thread.
+ */
+static vector< vector<int> > signalFDs(sigRTNUM);
 
 /** \brief Make bar output
  *
  * Takes individual module outputs and puts them together for printing.
+ * Modules with empty output (e.g., the RAID module on a machine with no arrays) are skipped, so that they do not leave empty segments between delimiters.
  *
- * \param[in] moduleOutput vector of individual module outputs
+ * \param[in,out] moduleOutput vector of individual module output slots
  * \param[in] delimiter delimiter character(s) between modules
  * \param[out] barText compiled text to be printed to the bar
  */
-void makeBarOutput(const vector<string> &moduleOutput, const string &delimiter, string &barText){
+void makeBarOutput(vector<OutputSlot> &moduleOutput, const string &delimiter, string &barText){
 	barText.clear();
-	for (auto moIt = moduleOutput.begin(); moIt != (moduleOutput.end() - 1); ++moIt){
-		barText += (*moIt) + delimiter;
+	for (auto &slot : moduleOutput){
+		const string &text = slot.read();
+		if ( text.empty() ) {
+			continue;
+		}
+		if ( !barText.empty() ) {
+			barText += delimiter;
+		}
+		barText += text;
 	}
-	barText += moduleOutput.back();
 }
 
-/** \brief Render the bar
+/** \brief Dispatch real-time signals
  *
- * Renders the bar text by printing the provided string to the root window.
- * This is how dwm handles status bars.
+ * Receives real-time signals from a `signalfd` and wakes all module threads that use the signal through their event file descriptors.
+ * Because the signals are blocked in all threads, nothing is done in signal handler context and no signal is lost.
  *
- * \param[in] barOutput text to be displayed
+ * \param[in] signalFD `signalfd` file descriptor for the real-time signals
  */
-void printRoot(const string &barOutput){
-	Display *d = XOpenDisplay(NULL);
-	if (d == nullptr) {
-		return;         // fail silently
+void dispatchSignals(const int signalFD){
+	struct signalfd_siginfo sigInfo;
+	while (true) {
+		if (read( signalFD, &sigInfo, sizeof(sigInfo) ) != sizeof(sigInfo)) {
+			continue;
+		}
+		const int sigInd = static_cast<int>(sigInfo.ssi_signo) - SIGRTMIN;
+		if ( (sigInd < 0) || (sigInd >= sigRTNUM) ) { // do nothing silently if wrong signal received
+			continue;
+		}
+		const uint64_t increment = 1;
+		for (auto &moduleFD : signalFDs[sigInd]){
+			write( moduleFD, &increment, sizeof(increment) );
+		}
 	}
-	const int32_t screen = DefaultScreen(d);
-	const Window root    = RootWindow(d, screen);
-	XStoreName( d, root, barOutput.c_str() );
-	XCloseDisplay(d);
 }
 
-/** \brief Process real-time signals
+/** \brief Create a module
  *
- * Receive and process real-time signals to trigger relevant modules.
+ * Checks the module description from the configuration file and creates the corresponding module object.
+ * Exits with an error message if the description is malformed.
  *
- * \param[in] sig signal number (starting at `SIGRTMIN`)
+ * \param[in] description module description vector
+ * \param[in] barName name of the bar the module belongs to (for error messages)
+ * \param[in,out] output pointer to the output slot
+ * \param[in,out] trigger pointer to the render trigger for change signaling
+ * \param[out] rtSig real-time signal ID of the module
+ * \return pointer to the new module object
  */
-void processSignal(int sig){
-	if ( (sig < SIGRTMIN) || (sig > SIGRTMAX) ) { // do nothing silently if wrong signal received
-		return;
+unique_ptr<Module> makeModule(const vector<string> &description, const string &barName, OutputSlot *output, RenderTrigger *trigger, int32_t &rtSig){
+	if (description.size() < 4) {
+		cerr << "ERROR: " << barName << " bar module description vector must be have at least four elements, yours has " << description.size() << " (module " << description[0] << ")\n";
+		exit(1);
 	}
-	size_t sigInd = sig - SIGRTMIN;
-	signalCondition[sigInd].notify_one();
+	bool align       = false;
+	int32_t timeout  = externTimeout;
+	for (size_t iOpt = 4; iOpt < description.size(); ++iOpt) {
+		if (description[iOpt] == "align") {
+			align = true;
+		} else if (description[iOpt].compare(0, 8, "timeout=") == 0) {
+			timeout = stoi( description[iOpt].substr(8) );
+			if (timeout < 0) {
+				cerr << "ERROR: timeout cannot be negative, yours is " << timeout << " (module " << description[0] << ")\n";
+				exit(1);
+			}
+		} else {
+			cerr << "ERROR: unknown module option " << description[iOpt] << " (module " << description[0] << ")\n";
+			exit(1);
+		}
+	}
+	int32_t interval = stoi(description[2]);
+	if (interval < 0) {
+		cerr << "ERROR: refresh interval cannot be negative, yours is " << interval << " (module " << description[0] << ")\n";
+		exit(2);
+	}
+	rtSig = stoi(description[3]);
+	if ( (rtSig < 0) || (rtSig >= sigRTNUM) ) {
+		cerr << "ERROR: real-time signal must be between 0 and " << sigRTNUM - 1 << ", yours is " << rtSig << " (module " << description[0] << ")\n";
+		exit(3);
+	}
+	int sigFD = -1;
+	if (!useEventLoop) {
+		sigFD = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		if (sigFD != -1) {
+			signalFDs[rtSig].push_back(sigFD);
+		}
+	}
+	unique_ptr<Module> module;
+	if (description[1] == "stream") {
+		module.reset( new ModuleStream(interval, description[0], output, trigger, sigFD) );
+	} else if (description[1] == "external") {
+		module.reset( new ModuleExtern(interval, description[0], timeout, externTimeoutMarker, output, trigger, sigFD) );
+	} else if (description[0] == "ModuleDate") {
+		module.reset( new ModuleDate(interval, dateFormat, output, trigger, sigFD) );
+	} else if (description[0] == "ModuleBattery") {
+		module.reset( new ModuleBattery(interval, powerSupplyRoot, batteryGlyphs, output, trigger, sigFD) );
+	} else if (description[0] == "ModuleCPU") {
+		module.reset( new ModuleCPU(interval, hwmonRoot, cpuSensors, cpuSensorSummary, cpuTempHysteresis, output, trigger, sigFD) );
+	} else if (description[0] == "ModuleGPU") {
+		module.reset( new ModuleGPU(interval, drmRoot, gpuCard, gpuCommand, gpuTempHysteresis, output, trigger, sigFD) );
+	} else if (description[0] == "ModuleCPUCores") {
+		module.reset( new ModuleCPUCores(interval, cpuTopCores, output, trigger, sigFD) );
+	} else if (description[0] == "ModuleRAM") {
+		module.reset( new ModuleRAM(interval, memFields, output, trigger, sigFD) );
+	} else if (description[0] == "ModulePacman") {
+		module.reset( new ModulePacman(interval, pacmanDBRoot, pacmanRepositories, pacmanIgnored, pacmanGlyph, output, trigger, sigFD) );
+	} else if (description[0] == "ModuleMail") {
+		module.reset( new ModuleMail(interval, mailRoot, mailFolder, mailGlyph, output, trigger, sigFD) );
+	} else if (description[0] == "ModuleWifi") {
+		module.reset( new ModuleWifi(interval, wifiInterface, wifiLevels, wifiBars, wifiDisconnected, output, trigger, sigFD) );
+	} else if (description[0] == "ModuleNet") {
+		module.reset( new ModuleNet(interval, netClassRoot, netInterfaces, output, trigger, sigFD) );
+	} else if (description[0] == "ModuleDisk") {
+		module.reset( new ModuleDisk(interval, fsNames, fsTypes, milliseconds(fsTimeout), fsStaleMarker, fsUnmountedMarker, fsReadOnlyMarker, output, trigger, sigFD) );
+	} else if (description[0] == "ModuleRAID") {
+		module.reset( new ModuleRAID(interval, raidProgressInterval, output, trigger, sigFD) );
+	} else {
+		cerr << "ERROR: unknown internal module " << description[0] << "\n";
+		exit(4);
+	}
+	module->alignToClock(align);
+	return module;
 }
 
 int main(){
+	// real-time signals are consumed through a signalfd, so they must be blocked in every thread
+	sigset_t rtSet;
+	sigemptyset(&rtSet);
 	for (int sigID = SIGRTMIN; sigID <= SIGRTMAX; sigID++) {
-		signal(sigID, processSignal);
+		sigaddset(&rtSet, sigID);
 	}
-	mutex mtx;
-	condition_variable commonCond; // this triggers printing to the bar from individual modules
-	vector<string> topModuleOutputs( topModuleList.size() );
-	vector<thread> moduleThreads;
+	pthread_sigmask(SIG_BLOCK, &rtSet, nullptr);
+	RenderTrigger renderTrigger; // this triggers printing to the bar from individual modules
+	vector< unique_ptr<Module> > modules;
+	vector<int32_t> moduleSignals;
+	vector<OutputSlot> topModuleOutputs( topModuleList.size() );
 	size_t moduleID = 0;
 	for (auto &tb : topModuleList){
-		if (tb.size() != 4) {
-			cerr << "ERROR: top bar module description vector must be have exactly four elements, yours has " << tb.size() << " (module " << tb[0] << ")\n";
-			exit(1);
-		}
-		if (tb[1] == "external") {
-			int32_t interval = stoi(tb[2]);
-			if (interval < 0) {
-				cerr << "ERROR: refresh interval cannot be negative, yours is " << interval << " (module " << tb[0] << ")\n";
-				exit(2);
-			}
-			int32_t rtSig = stoi(tb[3]);
-			if (rtSig < 0) {
-				cerr << "ERROR: real-time signal cannot be negative, yours is " << rtSig << " (module " << tb[0] << ")\n";
-				exit(3);
-			}
-			moduleThreads.push_back(thread{ModuleExtern(interval, tb[0], &topModuleOutputs[moduleID], &commonCond, &signalCondition[rtSig])});
-		} else {
-			int32_t interval = stoi(tb[2]);
-			if (interval < 0) {
-				cerr << "ERROR: refresh interval cannot be negative, yours is " << interval << " (module " << tb[0] << ")\n";
-				exit(2);
-			}
-			int32_t rtSig = stoi(tb[3]);
-			if (rtSig < 0) {
-				cerr << "ERROR: real-time signal cannot be negative, yours is " << rtSig << " (module " << tb[0] << ")\n";
-				exit(3);
-			}
-			if (tb[0] == "ModuleDate") {
-				moduleThreads.push_back(thread{ModuleDate(interval, dateFormat, &topModuleOutputs[moduleID], &commonCond, &signalCondition[rtSig])});
-			} else if (tb[0] == "ModuleBattery") {
-				moduleThreads.push_back(thread{ModuleBattery(interval, &topModuleOutputs[moduleID], &commonCond, &signalCondition[rtSig])});
-			} else if (tb[0] == "ModuleCPU") {
-				moduleThreads.push_back(thread{ModuleCPU(interval, &topModuleOutputs[moduleID], &commonCond, &signalCondition[rtSig])});
-			} else if (tb[0] == "ModuleRAM") {
-				moduleThreads.push_back(thread{ModuleRAM(interval, &topModuleOutputs[moduleID], &commonCond, &signalCondition[rtSig])});
-			} else if (tb[0] == "ModuleDisk") {
-				moduleThreads.push_back(thread{ModuleDisk(interval, fsNames, &topModuleOutputs[moduleID], &commonCond, &signalCondition[rtSig])});
-			} else {
-				cerr << "ERROR: unknown internal module " << tb[0] << "\n";
-				exit(4);
-			}
-		}
+		int32_t rtSig = 0;
+		modules.push_back( makeModule(tb, "top", &topModuleOutputs[moduleID], &renderTrigger, rtSig) );
+		moduleSignals.push_back(rtSig);
 		moduleID++;
 	}
-	vector<string> bottomModuleOutputs;
+	vector<OutputSlot> bottomModuleOutputs(twoBars ? bottomModuleList.size() : 0);
 	if (twoBars) {
-		bottomModuleOutputs.resize( bottomModuleList.size() );
 		moduleID = 0;
 		for (auto &bb : bottomModuleList){
-			if (bb.size() != 4) {
-				cerr << "ERROR: top bar module description vector must be have exactly four elements, yours has " << bb.size() << " (module " << bb[0] << ")\n";
-				exit(1);
-			}
-			if (bb[1] == "external") {
-				int32_t interval = stoi(bb[2]);
-				if (interval < 0) {
-					cerr << "ERROR: refresh interval cannot be negative, yours is " << interval << " (module " << bb[0] << ")\n";
-					exit(2);
-				}
-				int32_t rtSig = stoi(bb[3]);
-				if (rtSig < 0) {
-					cerr << "ERROR: real-time signal cannot be negative, yours is " << rtSig << " (module " << bb[0] << ")\n";
-					exit(3);
-				}
-				moduleThreads.push_back(thread{ModuleExtern(interval, bb[0], &bottomModuleOutputs[moduleID], &commonCond, &signalCondition[rtSig])});
-			} else {
-				int32_t interval = stoi(bb[2]);
-				if (interval < 0) {
-					cerr << "ERROR: refresh interval cannot be negative, yours is " << interval << " (module " << bb[0] << ")\n";
-					exit(2);
-				}
-				int32_t rtSig = stoi(bb[3]);
-				if (rtSig < 0) {
-					cerr << "ERROR: real-time signal cannot be negative, yours is " << rtSig << " (module " << bb[0] << ")\n";
-					exit(3);
-				}
-				if (bb[0] == "ModuleDate") {
-					moduleThreads.push_back(thread{ModuleDate(interval, dateFormat, &bottomModuleOutputs[moduleID], &commonCond, &signalCondition[rtSig])});
-				} else if (bb[0] == "ModuleBattery") {
-					moduleThreads.push_back(thread{ModuleBattery(interval, &bottomModuleOutputs[moduleID], &commonCond, &signalCondition[rtSig])});
-				} else if (bb[0] == "ModuleCPU") {
-					moduleThreads.push_back(thread{ModuleCPU(interval, &bottomModuleOutputs[moduleID], &commonCond, &signalCondition[rtSig])});
-				} else if (bb[0] == "ModuleRAM") {
-					moduleThreads.push_back(thread{ModuleRAM(interval, &bottomModuleOutputs[moduleID], &commonCond, &signalCondition[rtSig])});
-				} else if (bb[0] == "ModuleDisk") {
-					moduleThreads.push_back(thread{ModuleDisk(interval, fsNames, &bottomModuleOutputs[moduleID], &commonCond, &signalCondition[rtSig])});
-				} else {
-					cerr << "ERROR: unknown internal module " << bb[0] << "\n";
-					exit(4);
-				}
-			}
+			int32_t rtSig = 0;
+			modules.push_back( makeModule(bb, "bottom", &bottomModuleOutputs[moduleID], &renderTrigger, rtSig) );
+			moduleSignals.push_back(rtSig);
 			moduleID++;
 		}
 	}
+	vector<thread> moduleThreads;
+	vector<const Module*> modulePointers;
+	for (auto &m : modules){
+		modulePointers.push_back( m.get() );
+	}
+	unique_ptr<EventLoop> eventLoop;
+	if (useEventLoop) {
+		try {
+			eventLoop.reset( new EventLoop(modulePointers, moduleSignals) );
+		} catch (std::exception &problem) {
+			cerr << "ERROR: " << problem.what() << "\n";
+			exit(5);
+		}
+		moduleThreads.push_back( thread{ std::cref(*eventLoop) } );
+	} else {
+		const int signalFD = signalfd(-1, &rtSet, SFD_CLOEXEC);
+		if (signalFD == -1) {
+			cerr << "ERROR: failed to create the signal file descriptor\n";
+			exit(5);
+		}
+		moduleThreads.push_back( thread{dispatchSignals, signalFD} );
+		for (auto &m : modulePointers){
+			moduleThreads.push_back( thread{ std::cref(*m) } );
+		}
+	}
+	RootRenderer renderer;
 	string barTextBottom;
 	string barText;
+	uint64_t nRequests = 0; // render statistics for the report
+	uint64_t nRenders  = 0;
+	steady_clock::time_point lastReport = steady_clock::now();
 	while (true) {
-		unique_lock<mutex> lk(mtx);
-		commonCond.wait(lk);
+		nRequests += renderTrigger.wait( milliseconds(coalesceWindow) );
+		nRenders++;
 		makeBarOutput(topModuleOutputs, topDelimiter, barText);
 		if (twoBars) {
 			makeBarOutput(bottomModuleOutputs, bottomDelimiter, barTextBottom);
 			// I personally like a little adding around the top bar. Change to suit your taste.
 			barText = " " + barText + " " + botTopDelimiter + barTextBottom;
 		}
-		lk.unlock();
-		printRoot(barText);
+		renderer.print(barText);
+		if (renderReportInterval) {
+			const steady_clock::time_point now = steady_clock::now();
+			if ( now - lastReport >= seconds(renderReportInterval) ) {
+				cerr << "dwmbar: " << nRequests << " module updates drawn in " << nRenders << " renders (" << nRequests - nRenders << " renders saved)\n";
+				lastReport = now;
+			}
+		}
 	}
 	for (auto &t : moduleThreads){
 		if ( t.joinable() ) {
@@ -233,4 +290,3 @@ int main(){
 	}
 	exit(0);
 }
-
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2020 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Single-threaded module scheduler (implementation)
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2020 Anthony J. Greenberg
+ * \version 0.9
+ *
+ *  Implementation of the event loop that runs all modules from one thread.
+ *
+ */
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <csignal>
+#include <cerrno>
+#include <vector>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
+
+#include "eventloop.hpp"
+#include "modules.hpp"
+
+using std::vector;
+using std::runtime_error;
+
+using namespace DWMBspace;
+
+EventLoop::EventLoop(const vector<const Module*> &modules, const vector<int32_t> &rtSignals) : modules_{modules}, timerFDs_(modules.size(), -1), signalTargets_(SIGRTMAX - SIGRTMIN + 1), epollFD_{-1}, signalFD_{-1} {
+	epollFD_ = epoll_create1(EPOLL_CLOEXEC);
+	if (epollFD_ == -1) {
+		throw runtime_error("Failed to create the epoll file descriptor");
+	}
+	sigset_t rtSet;
+	sigemptyset(&rtSet);
+	for (int sigID = SIGRTMIN; sigID <= SIGRTMAX; sigID++) {
+		sigaddset(&rtSet, sigID);
+	}
+	signalFD_ = signalfd(-1, &rtSet, SFD_CLOEXEC);
+	if (signalFD_ == -1) {
+		close(epollFD_);
+		throw runtime_error("Failed to create the signal file descriptor");
+	}
+	struct epoll_event event;
+	event.events   = EPOLLIN;
+	event.data.u64 = modules_.size(); // the index past the last module identifies the signal descriptor
+	epoll_ctl(epollFD_, EPOLL_CTL_ADD, signalFD_, &event);
+	for (size_t iMod = 0; iMod < modules_.size(); ++iMod) {
+		if ( static_cast<size_t>(rtSignals[iMod]) < signalTargets_.size() ) {
+			signalTargets_[rtSignals[iMod]].push_back(iMod);
+		}
+		if (modules_[iMod]->eventFD_ != -1) {
+			event.events   = EPOLLIN;
+			event.data.u64 = modules_.size() + 1 + iMod; // indexes past the signal descriptor identify module event descriptors
+			epoll_ctl(epollFD_, EPOLL_CTL_ADD, modules_[iMod]->eventFD_, &event);
+		}
+		const uint32_t interval = modules_[iMod]->refreshInterval_;
+		if (interval == 0) {
+			continue;
+		}
+		timerFDs_[iMod] = timerfd_create( (modules_[iMod]->alignToClock_ ? CLOCK_REALTIME : CLOCK_MONOTONIC), TFD_CLOEXEC );
+		if (timerFDs_[iMod] == -1) {
+			closeDescriptors_();
+			throw runtime_error("Failed to create a timer file descriptor");
+		}
+		armTimer_(iMod);
+		event.events   = EPOLLIN;
+		event.data.u64 = iMod;
+		epoll_ctl(epollFD_, EPOLL_CTL_ADD, timerFDs_[iMod], &event);
+	}
+}
+
+EventLoop::~EventLoop(){
+	closeDescriptors_();
+}
+
+void EventLoop::closeDescriptors_(){
+	for (auto &tfd : timerFDs_){
+		if (tfd != -1) {
+			close(tfd);
+			tfd = -1;
+		}
+	}
+	if (signalFD_ != -1) {
+		close(signalFD_);
+		signalFD_ = -1;
+	}
+	if (epollFD_ != -1) {
+		close(epollFD_);
+		epollFD_ = -1;
+	}
+}
+
+void EventLoop::armTimer_(const size_t &moduleInd) const {
+	const Module *mod = modules_[moduleInd];
+	struct itimerspec period;
+	period.it_interval.tv_sec  = mod->refreshInterval_;
+	period.it_interval.tv_nsec = 0;
+	period.it_value.tv_nsec    = 0;
+	if (mod->alignToClock_) {
+		// the timer is cancelled if the wall clock is set, so that it can be re-aligned
+		period.it_value.tv_sec = mod->nextAlignedTime_( time(nullptr) );
+		timerfd_settime(timerFDs_[moduleInd], TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &period, nullptr);
+	} else {
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		period.it_value.tv_sec  = now.tv_sec + mod->refreshInterval_;
+		period.it_value.tv_nsec = now.tv_nsec;
+		timerfd_settime(timerFDs_[moduleInd], TFD_TIMER_ABSTIME, &period, nullptr);
+	}
+}
+
+void EventLoop::operator()() const {
+	for (auto &mod : modules_){
+		mod->runModule_();
+	}
+	const int maxEvents = 16;
+	struct epoll_event events[maxEvents];
+	while (true) {
+		const int nEvents = epoll_wait(epollFD_, events, maxEvents, -1);
+		if (nEvents == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return;
+		}
+		for (int iEv = 0; iEv < nEvents; ++iEv) {
+			const size_t source = static_cast<size_t>(events[iEv].data.u64);
+			if ( source == modules_.size() ) {
+				struct signalfd_siginfo sigInfo;
+				if (read( signalFD_, &sigInfo, sizeof(sigInfo) ) != sizeof(sigInfo)) {
+					continue;
+				}
+				const size_t sigInd = sigInfo.ssi_signo - SIGRTMIN;
+				if ( sigInd >= signalTargets_.size() ) { // do nothing silently if wrong signal received
+					continue;
+				}
+				for (auto &modInd : signalTargets_[sigInd]){
+					modules_[modInd]->runModule_();
+				}
+			} else if ( source > modules_.size() ) {
+				modules_[source - modules_.size() - 1]->handleEvents_();
+			} else {
+				uint64_t nExpirations = 0;
+				if (read( timerFDs_[source], &nExpirations, sizeof(nExpirations) ) == sizeof(nExpirations)) {
+					modules_[source]->runModule_(); // missed expirations are collapsed into one run
+				} else if (errno == ECANCELED) { // the wall clock changed
+					armTimer_(source);
+					modules_[source]->runModule_();
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2020 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Single-threaded module scheduler (definitions)
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2020 Anthony J. Greenberg
+ * \version 0.9
+ *
+ *  Definition of the event loop that runs all modules from one thread.
+ *
+ */
+#ifndef eventloop_hpp
+#define eventloop_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "modules.hpp"
+
+using std::vector;
+
+namespace DWMBspace {
+
+	/** \brief Event loop
+	 *
+	 * Runs all modules from a single thread instead of one thread per module.
+	 * Each module with a non-zero refresh interval gets a periodic `timerfd` with an absolute first deadline, and real-time signals are received through a `signalfd`.
+	 * Event-driven modules add their own `epoll` descriptors. All file descriptors are watched with `epoll`. Real-time signals must be blocked in every thread before the loop is created.
+	 */
+	class EventLoop {
+	public:
+		/** \brief Default constructor */
+		EventLoop() = delete;
+		/** \brief Constructor
+		 *
+		 * Sets up the timers and the signal file descriptor. Throws `std::runtime_error` if a file descriptor cannot be created.
+		 *
+		 * \param[in] modules pointers to the modules to run
+		 * \param[in] rtSignals real-time signal ID for each module
+		 */
+		EventLoop(const vector<const Module*> &modules, const vector<int32_t> &rtSignals);
+		/** \brief Copy constructor (deleted) */
+		EventLoop(const EventLoop &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		EventLoop& operator=(const EventLoop &in) = delete;
+		/** \brief Destructor */
+		~EventLoop();
+		/** \brief Run the loop
+		 *
+		 * Runs every module once and then waits for timer expirations or real-time signals.
+		 */
+		void operator()() const;
+	private:
+		/** \brief Modules */
+		vector<const Module*> modules_;
+		/** \brief Timer file descriptors
+		 *
+		 * One per module, -1 if the module only responds to signals.
+		 */
+		vector<int> timerFDs_;
+		/** \brief Modules to run for each real-time signal */
+		vector< vector<size_t> > signalTargets_;
+		/** \brief `epoll` file descriptor */
+		int epollFD_;
+		/** \brief `signalfd` file descriptor */
+		int signalFD_;
+		/** \brief Arm a module timer
+		 *
+		 * Sets the first expiration as an absolute time and the period to the module's refresh interval.
+		 * Timers of modules aligned to the wall clock use `CLOCK_REALTIME`, the rest `CLOCK_MONOTONIC`.
+		 *
+		 * \param[in] moduleInd module index
+		 */
+		void armTimer_(const size_t &moduleInd) const;
+		/** \brief Close all file descriptors */
+		void closeDescriptors_();
+	};
+}
+
+#endif // eventloop_hpp
@@ -28,7 +28,29 @@
  */
 #include <cstddef>
 #include <cstdio>
+#include <cstring>
+#include <cctype>
 #include <sys/statvfs.h>
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <zlib.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+#include <linux/nl80211.h>
+#include <net/if.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <csignal>
+#include <cstdlib>
+#include <cerrno>
 #include <ios>
 #include <string>
 #include <sstream>
@@ -39,13 +61,17 @@
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <utility>
 
 #include "modules.hpp"
 
 using std::string;
-using std::stof;
 using std::stoi;
 using std::to_string;
+using std::pair;
 using std::stringstream;
 using std::fstream;
 using std::ios;
@@ -57,285 +83,2840 @@ using std::localtime;
 using std::this_thread::sleep_for;
 using std::mutex;
 using std::unique_lock;
+using std::lock_guard;
 using std::chrono::seconds;
+using std::chrono::steady_clock;
+using std::chrono::system_clock;
+using std::chrono::nanoseconds;
 
 using namespace DWMBspace;
 
+/** \brief Time left until a deadline
+ *
+ * Rounds up, so that a wait for the returned time does not end before the deadline.
+ *
+ * \param[in] timeLeft time left
+ * \return time left in milliseconds
+ */
+static int millisecondsLeft(const nanoseconds &timeLeft){
+	return static_cast<int>( (timeLeft.count() + 999999)/1000000 );
+}
+
+/** \brief Open a kernel uevent socket
+ *
+ * Opens a non-blocking netlink socket subscribed to kernel object uevents.
+ *
+ * \return socket file descriptor, -1 on failure
+ */
+static int openUeventSocket(){
+	const int ueventFD = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+	if (ueventFD == -1) {
+		return -1;
+	}
+	struct sockaddr_nl address;
+	memset( &address, 0, sizeof(address) );
+	address.nl_family = AF_NETLINK;
+	address.nl_groups = 1;   // kernel uevents (as opposed to udev re-broadcasts)
+	if (bind( ueventFD, reinterpret_cast<struct sockaddr*>(&address), sizeof(address) ) == -1) {
+		close(ueventFD);
+		return -1;
+	}
+	return ueventFD;
+}
+
+/** \brief Receive kernel uevents
+ *
+ * Reads all pending uevents from a uevent socket.
+ *
+ * \param[in] ueventFD uevent socket file descriptor
+ * \param[in] key uevent key/value pair to look for (e.g., `SUBSYSTEM=power_supply`)
+ * \return `true` if any of the uevents contained the key/value pair
+ */
+static bool receiveUevents(const int &ueventFD, const char *key){
+	char buffer[8192];
+	const size_t keyLength = strlen(key);
+	bool found = false;
+	while (true) {
+		const ssize_t nReceived = recv(ueventFD, buffer, sizeof(buffer), 0);
+		if (nReceived <= 0) {
+			if ( (nReceived == -1) && (errno == EINTR) ) {
+				continue;
+			}
+			break;
+		}
+		// uevent messages are null-separated strings, so memmem() rather than strstr()
+		if ( memmem(buffer, static_cast<size_t>(nReceived), key, keyLength) != nullptr ) {
+			found = true;
+		}
+	}
+	return found;
+}
+
+/** \brief Open a generic netlink socket
+ *
+ * \return non-blocking socket file descriptor, -1 on failure
+ */
+static int openGenericNetlink(){
+	const int netlinkFD = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_GENERIC);
+	if (netlinkFD == -1) {
+		return -1;
+	}
+	struct sockaddr_nl address;
+	memset( &address, 0, sizeof(address) );
+	address.nl_family = AF_NETLINK;
+	if (bind( netlinkFD, reinterpret_cast<struct sockaddr*>(&address), sizeof(address) ) == -1) {
+		close(netlinkFD);
+		return -1;
+	}
+	return netlinkFD;
+}
+
+/** \brief Find a netlink attribute
+ *
+ * \param[in] start start of the attributes
+ * \param[in] end end of the attributes
+ * \param[in] type attribute type
+ * \return pointer to the attribute, `nullptr` if not found
+ */
+static const struct nlattr* findAttribute(const char *start, const char *end, const uint16_t &type){
+	while ( end - start >= static_cast<ptrdiff_t>(NLA_HDRLEN) ) {
+		const struct nlattr *attribute = reinterpret_cast<const struct nlattr*>(start);
+		if ( (attribute->nla_len < NLA_HDRLEN) || (attribute->nla_len > end - start) ) {
+			return nullptr;
+		}
+		if ( (attribute->nla_type & NLA_TYPE_MASK) == type ) {
+			return attribute;
+		}
+		start += NLA_ALIGN(attribute->nla_len);
+	}
+	return nullptr;
+}
+
+/** \brief Send a generic netlink request
+ *
+ * Sends a request with a single attribute.
+ *
+ * \param[in] netlinkFD generic netlink socket
+ * \param[in] family generic netlink family ID
+ * \param[in] command family command
+ * \param[in] attributeType attribute type
+ * \param[in] attributeData attribute data
+ * \param[in] attributeLength attribute data length
+ * \param[in] sequence message sequence number
+ * \return `true` if the request was sent
+ */
+static bool sendGenericRequest(const int &netlinkFD, const uint16_t &family, const uint8_t &command, const uint16_t &attributeType, const void *attributeData,
+		const uint16_t &attributeLength, const uint32_t &sequence){
+	alignas(struct nlmsghdr) char message[256];
+	const size_t messageLength = NLMSG_HDRLEN + GENL_HDRLEN + NLA_HDRLEN + NLA_ALIGN(attributeLength);
+	if ( messageLength > sizeof(message) ) {
+		return false;
+	}
+	memset(message, 0, messageLength);
+	struct nlmsghdr *header  = reinterpret_cast<struct nlmsghdr*>(message);
+	header->nlmsg_len        = static_cast<uint32_t>(messageLength);
+	header->nlmsg_type       = family;
+	header->nlmsg_flags      = NLM_F_REQUEST;
+	header->nlmsg_seq        = sequence;
+	struct genlmsghdr *genericHeader = static_cast<struct genlmsghdr*>( NLMSG_DATA(header) );
+	genericHeader->cmd       = command;
+	genericHeader->version   = 1;
+	struct nlattr *attribute = reinterpret_cast<struct nlattr*>(message + NLMSG_HDRLEN + GENL_HDRLEN);
+	attribute->nla_len       = static_cast<uint16_t>(NLA_HDRLEN + attributeLength);
+	attribute->nla_type      = attributeType;
+	memcpy(message + NLMSG_HDRLEN + GENL_HDRLEN + NLA_HDRLEN, attributeData, attributeLength);
+	struct sockaddr_nl kernel;
+	memset( &kernel, 0, sizeof(kernel) );
+	kernel.nl_family = AF_NETLINK;
+	return sendto( netlinkFD, message, messageLength, 0, reinterpret_cast<struct sockaddr*>(&kernel), sizeof(kernel) ) == static_cast<ssize_t>(messageLength);
+}
+
+/** \brief Receive a generic netlink reply
+ *
+ * Waits up to a second for the reply to a request, skipping messages that answer other requests.
+ *
+ * \param[in] netlinkFD generic netlink socket
+ * \param[in] sequence request sequence number
+ * \param[out] buffer receive buffer
+ * \param[in] size buffer size
+ * \return pointer to the reply message in the buffer, `nullptr` on error or timeout
+ */
+static const struct nlmsghdr* receiveGenericReply(const int &netlinkFD, const uint32_t &sequence, char *buffer, const size_t &size){
+	const steady_clock::time_point deadline = steady_clock::now() + seconds(1);
+	while (true) {
+		const int timeLeft = millisecondsLeft( deadline - steady_clock::now() );
+		if (timeLeft <= 0) {
+			return nullptr;
+		}
+		struct pollfd netlinkPoll;
+		netlinkPoll.fd     = netlinkFD;
+		netlinkPoll.events = POLLIN;
+		if (poll(&netlinkPoll, 1, timeLeft) <= 0) {
+			continue;
+		}
+		ssize_t nReceived = recv(netlinkFD, buffer, size, 0);
+		if (nReceived <= 0) {
+			if ( (nReceived == -1) && ( (errno == EINTR) || (errno == EAGAIN) ) ) {
+				continue;
+			}
+			return nullptr;
+		}
+		int length = static_cast<int>(nReceived);
+		for (const struct nlmsghdr *message = reinterpret_cast<const struct nlmsghdr*>(buffer); NLMSG_OK(message, length); message = NLMSG_NEXT(message, length)) {
+			if (message->nlmsg_seq != sequence) {
+				continue;
+			}
+			return (message->nlmsg_type == NLMSG_ERROR ? nullptr : message);
+		}
+	}
+}
+
+/** \brief Resolve a generic netlink family
+ *
+ * Asks the generic netlink controller for the ID of a family and of one of its multicast groups.
+ *
+ * \param[in] netlinkFD generic netlink socket
+ * \param[in] familyName family name
+ * \param[in] groupName multicast group name
+ * \param[out] groupID multicast group ID (0 if the group is not found)
+ * \return family ID, 0 if the family is not available
+ */
+static uint16_t resolveGenericFamily(const int &netlinkFD, const char *familyName, const char *groupName, uint32_t &groupID){
+	groupID = 0;
+	const uint32_t sequence = 1;
+	if ( !sendGenericRequest(netlinkFD, GENL_ID_CTRL, CTRL_CMD_GETFAMILY, CTRL_ATTR_FAMILY_NAME, familyName, static_cast<uint16_t>(strlen(familyName) + 1), sequence) ) {
+		return 0;
+	}
+	alignas(struct nlmsghdr) char buffer[8192];
+	const struct nlmsghdr *reply = receiveGenericReply( netlinkFD, sequence, buffer, sizeof(buffer) );
+	if (reply == nullptr) {
+		return 0;
+	}
+	const char *attributes = reinterpret_cast<const char*>(reply) + NLMSG_HDRLEN + GENL_HDRLEN;
+	const char *end        = reinterpret_cast<const char*>(reply) + reply->nlmsg_len;
+	const struct nlattr *familyAttribute = findAttribute(attributes, end, CTRL_ATTR_FAMILY_ID);
+	if (familyAttribute == nullptr) {
+		return 0;
+	}
+	uint16_t familyID;
+	memcpy( &familyID, reinterpret_cast<const char*>(familyAttribute) + NLA_HDRLEN, sizeof(familyID) );
+	const struct nlattr *groups = findAttribute(attributes, end, CTRL_ATTR_MCAST_GROUPS);
+	if (groups != nullptr) {
+		// each group is a nested attribute with the group name and ID
+		const char *group     = reinterpret_cast<const char*>(groups) + NLA_HDRLEN;
+		const char *groupsEnd = reinterpret_cast<const char*>(groups) + groups->nla_len;
+		while ( groupsEnd - group >= static_cast<ptrdiff_t>(NLA_HDRLEN) ) {
+			const struct nlattr *groupAttribute = reinterpret_cast<const struct nlattr*>(group);
+			if ( (groupAttribute->nla_len < NLA_HDRLEN) || (groupAttribute->nla_len > groupsEnd - group) ) {
+				break;
+			}
+			const char *groupEnd          = group + groupAttribute->nla_len;
+			const struct nlattr *nameAttr = findAttribute(group + NLA_HDRLEN, groupEnd, CTRL_ATTR_MCAST_GRP_NAME);
+			const struct nlattr *idAttr   = findAttribute(group + NLA_HDRLEN, groupEnd, CTRL_ATTR_MCAST_GRP_ID);
+			if ( (nameAttr != nullptr) && (idAttr != nullptr) && (strcmp(reinterpret_cast<const char*>(nameAttr) + NLA_HDRLEN, groupName) == 0) ) {
+				memcpy( &groupID, reinterpret_cast<const char*>(idAttr) + NLA_HDRLEN, sizeof(groupID) );
+				break;
+			}
+			group += NLA_ALIGN(groupAttribute->nla_len);
+		}
+	}
+	return familyID;
+}
+
+/** \brief Count the entries of a directory
+ *
+ * Hidden entries (names that start with a dot) are not counted.
+ *
+ * \param[in] path directory path
+ * \return number of entries
+ */
+static uint32_t countEntries(const string &path){
+	DIR *directory = opendir( path.c_str() );
+	if (directory == nullptr) {
+		return 0;
+	}
+	uint32_t count = 0;
+	struct dirent *entry;
+	while ( ( entry = readdir(directory) ) != nullptr ) {
+		if (entry->d_name[0] != '.') {
+			++count;
+		}
+	}
+	closedir(directory);
+	return count;
+}
+
+/** \brief Compare version segments
+ *
+ * Compares two versions without epoch or release the way `pacman` does (`rpmvercmp`): the versions are split into runs of digits and runs of letters,
+ * numeric runs are compared as numbers, numeric runs are newer than alphabetic ones, and a version with extra alphabetic runs (e.g., `1.0alpha`) is older.
+ *
+ * \param[in] first first version
+ * \param[in] firstEnd end of the first version
+ * \param[in] second second version
+ * \param[in] secondEnd end of the second version
+ * \return -1 if the first version is older, 1 if it is newer, 0 if they are the same
+ */
+static int compareVersionSegments(const char *first, const char *firstEnd, const char *second, const char *secondEnd){
+	if ( (firstEnd - first == secondEnd - second) && (memcmp(first, second, static_cast<size_t>(firstEnd - first)) == 0) ) {
+		return 0;
+	}
+	while ( (first < firstEnd) && (second < secondEnd) ) {
+		const char *firstSeparator  = first;
+		const char *secondSeparator = second;
+		while ( (first < firstEnd) && !isalnum( static_cast<unsigned char>(*first) ) ) {
+			++first;
+		}
+		while ( (second < secondEnd) && !isalnum( static_cast<unsigned char>(*second) ) ) {
+			++second;
+		}
+		if ( (first == firstEnd) || (second == secondEnd) ) {
+			break;
+		}
+		if (first - firstSeparator != second - secondSeparator) { // e.g., 1.0 vs 1..0
+			return (first - firstSeparator < second - secondSeparator ? -1 : 1);
+		}
+		const bool numeric = isdigit( static_cast<unsigned char>(*first) );
+		const char *firstRunEnd  = first;
+		const char *secondRunEnd = second;
+		if (numeric) {
+			while ( (firstRunEnd < firstEnd) && isdigit( static_cast<unsigned char>(*firstRunEnd) ) ) {
+				++firstRunEnd;
+			}
+			while ( (secondRunEnd < secondEnd) && isdigit( static_cast<unsigned char>(*secondRunEnd) ) ) {
+				++secondRunEnd;
+			}
+		} else {
+			while ( (firstRunEnd < firstEnd) && isalpha( static_cast<unsigned char>(*firstRunEnd) ) ) {
+				++firstRunEnd;
+			}
+			while ( (secondRunEnd < secondEnd) && isalpha( static_cast<unsigned char>(*secondRunEnd) ) ) {
+				++secondRunEnd;
+			}
+		}
+		if (secondRunEnd == second) { // the runs are of different kinds; numbers are newer
+			return (numeric ? 1 : -1);
+		}
+		if (numeric) {
+			while ( (first < firstRunEnd) && (*first == '0') ) {
+				++first;
+			}
+			while ( (second < secondRunEnd) && (*second == '0') ) {
+				++second;
+			}
+			if (firstRunEnd - first != secondRunEnd - second) {
+				return (firstRunEnd - first > secondRunEnd - second ? 1 : -1);
+			}
+		}
+		const size_t firstLength  = static_cast<size_t>(firstRunEnd - first);
+		const size_t secondLength = static_cast<size_t>(secondRunEnd - second);
+		const int comparison      = memcmp( first, second, std::min(firstLength, secondLength) );
+		if (comparison != 0) {
+			return (comparison < 0 ? -1 : 1);
+		}
+		if (firstLength != secondLength) {
+			return (firstLength < secondLength ? -1 : 1);
+		}
+		first  = firstRunEnd;
+		second = secondRunEnd;
+	}
+	if ( (first == firstEnd) && (second == secondEnd) ) {
+		return 0;
+	}
+	// the version with the remaining alphabetic run is older, e.g., 1.0alpha < 1.0; a remaining numeric run is newer, e.g., 1.0 < 1.0.1
+	if ( ( (first == firstEnd) && !isalpha( static_cast<unsigned char>(*second) ) ) || ( (first < firstEnd) && isalpha( static_cast<unsigned char>(*first) ) ) ) {
+		return -1;
+	}
+	return 1;
+}
+
+/** \brief Compare package versions
+ *
+ * Compares `[epoch:]version[-release]` strings the way `pacman` does (`vercmp`). Releases are compared only if both versions have one.
+ *
+ * \param[in] first first version
+ * \param[in] second second version
+ * \return -1 if the first version is older, 1 if it is newer, 0 if they are the same
+ */
+static int compareVersions(const string &first, const string &second){
+	if (first == second) {
+		return 0;
+	}
+	const char *versions[2] = {first.data(), second.data()};
+	const char *ends[2]     = {first.data() + first.size(), second.data() + second.size()};
+	const char *epochs[2][2];
+	const char *releases[2];
+	for (uint16_t iVer = 0; iVer < 2; ++iVer) {
+		const char *pos = versions[iVer];
+		while ( (pos < ends[iVer]) && isdigit( static_cast<unsigned char>(*pos) ) ) {
+			++pos;
+		}
+		if ( (pos < ends[iVer]) && (*pos == ':') ) {
+			epochs[iVer][0] = versions[iVer];
+			epochs[iVer][1] = pos;
+			versions[iVer]  = pos + 1;
+		} else {
+			epochs[iVer][0] = "0";
+			epochs[iVer][1] = epochs[iVer][0] + 1;
+		}
+		releases[iVer] = ends[iVer];
+		for (const char *dash = ends[iVer]; dash > versions[iVer]; --dash) {
+			if (dash[-1] == '-') {
+				releases[iVer] = dash;
+				break;
+			}
+		}
+	}
+	int comparison = compareVersionSegments(epochs[0][0], epochs[0][1], epochs[1][0], epochs[1][1]);
+	if (comparison != 0) {
+		return comparison;
+	}
+	const char *versionEnds[2] = { (releases[0] == ends[0] ? ends[0] : releases[0] - 1), (releases[1] == ends[1] ? ends[1] : releases[1] - 1) };
+	comparison = compareVersionSegments(versions[0], versionEnds[0], versions[1], versionEnds[1]);
+	if ( (comparison == 0) && (releases[0] != ends[0]) && (releases[1] != ends[1]) ) {
+		comparison = compareVersionSegments(releases[0], ends[0], releases[1], ends[1]);
+	}
+	return comparison;
+}
+
+/** \brief Split a package entry name
+ *
+ * Splits a `pacman` database entry name (`name-version-release`) into the package name and its version. Versions and releases cannot contain dashes.
+ *
+ * \param[in] entry entry name
+ * \param[in] length entry name length
+ * \param[out] name package name
+ * \param[out] version package version, including the epoch and release
+ * \return `false` if the entry name is not valid
+ */
+static bool splitPackageEntry(const char *entry, const size_t &length, string &name, string &version){
+	size_t nDashes = 0;
+	size_t split   = length;
+	while ( (split > 0) && (nDashes < 2) ) {
+		--split;
+		if (entry[split] == '-') {
+			++nDashes;
+		}
+	}
+	if ( (nDashes < 2) || (split == 0) ) {
+		return false;
+	}
+	name.assign(entry, split);
+	version.assign(entry + split + 1, length - split - 1);
+	return true;
+}
+
+/** \brief Read a sync database
+ *
+ * Reads the package names and versions from the entry names of a gzip-compressed or uncompressed tar archive.
+ *
+ * \param[in] path archive path
+ * \param[out] versions version of each package
+ */
+static void readSyncDatabase(const string &path, unordered_map<string, string> &versions){
+	versions.clear();
+	gzFile archive = gzopen(path.c_str(), "rb");
+	if (archive == nullptr) {
+		return;
+	}
+	gzbuffer(archive, 131072);
+	char header[512];
+	string longPath;      // entry path from a pax extended header, for paths that do not fit in the header
+	string lastEntry;
+	string name;
+	string version;
+	vector<char> extended;
+	while (gzread( archive, header, sizeof(header) ) == sizeof(header)) {
+		if (memcmp(header + 257, "ustar", 5) != 0) { // the end-of-archive blocks, or not a tar archive (e.g., zstd-compressed)
+			break;
+		}
+		uint64_t size = 0;
+		for (size_t iChar = 124; (iChar < 136) && (header[iChar] >= '0') && (header[iChar] <= '7'); ++iChar) {
+			size = size*8 + static_cast<uint64_t>(header[iChar] - '0');
+		}
+		const uint64_t paddedSize = (size + 511) & ~static_cast<uint64_t>(511);
+		if (header[156] == 'x') { // pax extended header; only the path record matters
+			extended.resize(paddedSize);
+			if ( (paddedSize > 0) && (gzread( archive, extended.data(), static_cast<unsigned>(paddedSize) ) != static_cast<int>(paddedSize)) ) {
+				break;
+			}
+			const char *record = static_cast<const char*>( memmem(extended.data(), size, " path=", 6) );
+			if (record != nullptr) {
+				const char *recordEnd = static_cast<const char*>( memchr(record, '\n', static_cast<size_t>(extended.data() + size - record)) );
+				longPath.assign(record + 6, recordEnd == nullptr ? extended.data() + size : recordEnd);
+			}
+			continue;
+		}
+		string entryPath;
+		if ( longPath.empty() ) {
+			entryPath.assign( header, strnlen(header, 100) );
+		} else {
+			entryPath.swap(longPath);
+			longPath.clear();
+		}
+		if ( (paddedSize > 0) && (gzseek(archive, static_cast<z_off_t>(paddedSize), SEEK_CUR) == -1) ) {
+			break;
+		}
+		// every package has a directory named after it
+		const size_t slash = entryPath.find('/');
+		const size_t entryLength = ( slash == string::npos ? entryPath.size() : slash );
+		if ( (entryLength > 0) && (lastEntry.compare(0, string::npos, entryPath, 0, entryLength) != 0) ) {
+			lastEntry.assign(entryPath, 0, entryLength);
+			if ( splitPackageEntry(lastEntry.data(), lastEntry.size(), name, version) ) {
+				versions[name] = version;
+			}
+		}
+	}
+	gzclose(archive);
+}
+
+/** \brief Parse an unsigned integer
+ *
+ * Skips any characters before the first digit and reads the decimal digits that follow.
+ * The value is 0 if there are no digits before the end of the buffer.
+ *
+ * \param[in] pos start of the text
+ * \param[in] end end of the buffer
+ * \param[out] value parsed value
+ * \return position after the last digit
+ */
+static const char* parseUnsigned(const char *pos, const char *end, uint64_t &value){
+	value = 0;
+	while ( (pos < end) && ( (*pos < '0') || (*pos > '9') ) ) {
+		if (*pos == '\0') {
+			return pos;
+		}
+		++pos;
+	}
+	while ( (pos < end) && (*pos >= '0') && (*pos <= '9') ) {
+		value = value*10 + static_cast<uint64_t>(*pos - '0');
+		++pos;
+	}
+	return pos;
+}
+
+/** \brief Read an unsigned integer from a file
+ *
+ * Reads a file that holds a single number, as is common in `sysfs`.
+ *
+ * \param[in] file file to read
+ * \return the value, 0 if the file cannot be read
+ */
+static uint64_t readUnsigned(const PersistentFile &file){
+	char buffer[32];
+	uint64_t value = 0;
+	const size_t nRead = file.read( buffer, sizeof(buffer) );
+	parseUnsigned(buffer, buffer + nRead, value);
+	return value;
+}
+
+/** \brief Read a whole file
+ *
+ * Grows the buffer until the file fits, so that files of unknown size (e.g., the mount table) are read in one piece.
+ *
+ * \param[in] file file to read
+ * \param[in,out] buffer buffer for the file contents; its size is kept between calls to avoid re-allocation
+ * \return number of bytes read, excluding the terminating null
+ */
+static size_t readWholeFile(const PersistentFile &file, vector<char> &buffer){
+	if ( buffer.empty() ) {
+		buffer.resize(4096);
+	}
+	size_t nRead;
+	while ( ( nRead = file.read( buffer.data(), buffer.size() ) ) == buffer.size() - 1 ) {
+		buffer.resize(2*buffer.size());
+	}
+	return nRead;
+}
+
+/** \brief Is a mount option list read-only?
+ *
+ * \param[in] options start of a comma-separated option list
+ * \param[in] end end of the line
+ * \return `true` if the first option is `ro`
+ */
+static bool readOnlyOptions(const char *options, const char *end){
+	return (end - options >= 2) && (options[0] == 'r') && (options[1] == 'o') && ( (end - options == 2) || (options[2] == ',') || (options[2] == ' ') );
+}
+
+/** \brief Parse the mount table
+ *
+ * Extracts the mount point, file system type, and read-only state of each mount in the `/proc/self/mountinfo` format.
+ * Escaped characters in mount points (e.g., `\040` for a space) are decoded.
+ * A mount is read-only if either the mount or its file system (e.g., after an `errors=remount-ro` error) is read-only.
+ *
+ * \param[in] text mount table text
+ * \param[in] size text size
+ * \param[out] mountPoints mount points
+ * \param[out] fsTypes file system type of each mount
+ * \param[out] readOnly read-only state of each mount
+ */
+static void parseMountInfo(const char *text, const size_t &size, vector<string> &mountPoints, vector<string> &fsTypes, vector<char> &readOnly){
+	mountPoints.clear();
+	fsTypes.clear();
+	readOnly.clear();
+	const char *end = text + size;
+	const char *pos = text;
+	while (pos < end) {
+		const char *lineEnd = static_cast<const char*>( memchr(pos, '\n', static_cast<size_t>(end - pos)) );
+		if (lineEnd == nullptr) {
+			lineEnd = end;
+		}
+		// mount ID, parent ID, device number, and root come before the mount point
+		const char *field = pos;
+		for (uint16_t iField = 0; (iField < 4) && (field < lineEnd); ++iField) {
+			field = static_cast<const char*>( memchr(field, ' ', static_cast<size_t>(lineEnd - field)) );
+			field = (field == nullptr ? lineEnd : field + 1);
+		}
+		// the file system type follows the " - " separator after a variable number of optional fields
+		const char *separator = static_cast<const char*>( memmem(field, static_cast<size_t>(lineEnd - field), " - ", 3) );
+		if (separator != nullptr) {
+			string mountPoint;
+			for (; (field < lineEnd) && (*field != ' '); ++field) {
+				if ( (*field == '\\') && (lineEnd - field > 3) ) {
+					mountPoint += static_cast<char>( (field[1] - '0')*64 + (field[2] - '0')*8 + (field[3] - '0') );
+					field += 3;
+				} else {
+					mountPoint += *field;
+				}
+			}
+			bool mountReadOnly  = readOnlyOptions(field + 1, lineEnd);
+			const char *type    = separator + 3;
+			const char *typeEnd = static_cast<const char*>( memchr(type, ' ', static_cast<size_t>(lineEnd - type)) );
+			if (typeEnd == nullptr) {
+				typeEnd = lineEnd;
+			} else {
+				const char *superOptions = static_cast<const char*>( memchr(typeEnd + 1, ' ', static_cast<size_t>(lineEnd - typeEnd - 1)) ); // after the mount source
+				if (superOptions != nullptr) {
+					mountReadOnly = mountReadOnly || readOnlyOptions(superOptions + 1, lineEnd);
+				}
+			}
+			mountPoints.push_back(mountPoint);
+			fsTypes.emplace_back(type, typeEnd);
+			readOnly.push_back(mountReadOnly ? 1 : 0);
+		}
+		pos = lineEnd + 1;
+	}
+}
+
+/** \brief Counter difference
+ *
+ * Counters of some drivers are 32 bits wide and wrap around. A decrease is taken as a wrap only if the previous value was in the top quarter of the 32-bit range
+ * and the current value is in the bottom quarter. Any other decrease means that the counter was reset (e.g., the interface was re-created), and the current value is the difference.
+ *
+ * \param[in] current current counter value
+ * \param[in] previous previous counter value
+ * \return counter difference
+ */
+static uint64_t counterDifference(const uint64_t &current, const uint64_t &previous){
+	if (current >= previous) {
+		return current - previous;
+	}
+	if ( (previous <= 0xffffffffULL) && (previous >= 0xc0000000ULL) && (current < 0x40000000ULL) ) {
+		return current + 0x100000000ULL - previous;
+	}
+	return current;
+}
+
+/** \brief Format a transfer rate
+ *
+ * Scales the rate to the largest binary unit that keeps the value at least 1, with one decimal place below 10.
+ *
+ * \param[in] bytesPerSecond rate in bytes per second
+ * \param[out] buffer output buffer
+ * \param[in] size buffer size
+ * \return number of characters written
+ */
+static int formatRate(const double &bytesPerSecond, char *buffer, const size_t &size){
+	const char units[] = "BKMGT";
+	double value  = bytesPerSecond;
+	size_t unitInd = 0;
+	while ( (value >= 1024.0) && (unitInd < sizeof(units) - 2) ) {
+		value /= 1024.0;
+		++unitInd;
+	}
+	return snprintf(buffer, size, (value < 10.0 ? "%.1f%c" : "%.0f%c"), value, units[unitInd]);
+}
+
+/** \brief Thermometer glyph thresholds in degrees Celsius */
+static const int64_t thermalThresholds[] = {35, 80};
+
+/** \brief Thermometer glyphs, from cool to hot */
+static const char *thermalGlyphs[] = {"\ue20c", "\ue20a", "\ue20b"};
+
+/** \brief Update the thermometer glyph level
+ *
+ * Switches to a hotter glyph as soon as a threshold is reached, but to a cooler one only once the temperature is below the threshold by the hysteresis, so that the glyph does not flicker.
+ *
+ * \param[in] temperature temperature in degrees Celsius
+ * \param[in] hysteresis hysteresis in degrees Celsius
+ * \param[in,out] level index of the glyph in `thermalGlyphs`
+ */
+static void updateThermalLevel(const int64_t &temperature, const int64_t &hysteresis, size_t &level){
+	while ( (level < 2) && (temperature >= thermalThresholds[level]) ) {
+		++level;
+	}
+	while ( (level > 0) && (temperature + hysteresis < thermalThresholds[level - 1]) ) {
+		--level;
+	}
+}
+
+/** \brief Read the output of a streaming command
+ *
+ * Reads everything available from the non-blocking output pipe and extracts the last complete line. Earlier lines are discarded, since they have already been superseded.
+ *
+ * \param[in] readFD read end of the output pipe
+ * \param[in] lengthLimit line length limit; longer lines are truncated
+ * \param[in,out] lineBuffer incomplete line read so far
+ * \param[out] line last complete line, unchanged if no line was completed
+ * \param[out] finished set to `true` if the command closed its output or the pipe cannot be read
+ * \return `true` if a line was completed
+ */
+static bool readLastLine(const int &readFD, const size_t &lengthLimit, string &lineBuffer, string &line, bool &finished){
+	char buffer[4096];
+	finished = false;
+	while (true) {
+		const ssize_t nRead = read( readFD, buffer, sizeof(buffer) );
+		if (nRead > 0) {
+			lineBuffer.append( buffer, static_cast<size_t>(nRead) );
+			continue;
+		}
+		if ( (nRead == 0) || ( (errno != EAGAIN) && (errno != EINTR) ) ) {
+			finished = true;
+		} else if (errno == EINTR) {
+			continue;
+		}
+		break;
+	}
+	bool complete       = false;
+	const size_t lastEnd = lineBuffer.rfind('\n');
+	if (lastEnd != string::npos) {
+		size_t lineStart = 0;
+		if (lastEnd > 0) {
+			const size_t previousEnd = lineBuffer.rfind('\n', lastEnd - 1);
+			lineStart = (previousEnd == string::npos ? 0 : previousEnd + 1);
+		}
+		line.assign( lineBuffer, lineStart, std::min(lastEnd - lineStart, lengthLimit) );
+		lineBuffer.erase(0, lastEnd + 1);
+		complete = true;
+	}
+	if (lineBuffer.size() > lengthLimit) { // a line that is too long; keep the beginning only
+		lineBuffer.resize(lengthLimit);
+	}
+	return complete;
+}
+
+/** \brief Find a GPU in the DRM class directory
+ *
+ * Looks for a card whose driver reports its load or frequency in `sysfs` (`amdgpu` or `i915`).
+ *
+ * \param[in] drmRoot DRM class directory
+ * \param[in] card card name; if empty, all cards are searched in name order
+ * \return card directory with a trailing slash, empty if no supported card was found
+ */
+static string findDRMCard(const string &drmRoot, const string &card){
+	vector<string> cardNames;
+	if ( card.empty() ) {
+		DIR *rootDir = opendir( drmRoot.c_str() );
+		if (rootDir == nullptr) {
+			return "";
+		}
+		struct dirent *entry;
+		while ( ( entry = readdir(rootDir) ) != nullptr ) {
+			// connectors (e.g., card0-DP-1) are in the same directory
+			if ( (strncmp(entry->d_name, "card", 4) == 0) && (entry->d_name[4] != '\0') && (entry->d_name[4 + strspn(entry->d_name + 4, "0123456789")] == '\0') ) {
+				cardNames.push_back(entry->d_name);
+			}
+		}
+		closedir(rootDir);
+		std::sort( cardNames.begin(), cardNames.end() );
+	} else {
+		cardNames.push_back(card);
+	}
+	for (auto &name : cardNames){
+		const string cardPath = drmRoot + "/" + name + "/";
+		if ( (access( (cardPath + "device/gpu_busy_percent").c_str(), R_OK ) == 0) || (access( (cardPath + "gt_act_freq_mhz").c_str(), R_OK ) == 0) ) {
+			return cardPath;
+		}
+	}
+	return "";
+}
+
+// static members
+const uint8_t OutputSlot::freshBit_  = 4;
+const uint8_t OutputSlot::indexMask_ = 3;
+
+bool OutputSlot::write(const string &output){
+	if (output == lastWritten_) {
+		return false;
+	}
+	lastWritten_     = output;
+	buffers_[back_]  = output; // assignment re-uses the buffer's capacity
+	back_            = middle_.exchange(back_ | freshBit_, std::memory_order_acq_rel) & indexMask_;
+	return true;
+}
+
+const string& OutputSlot::read(){
+	if (middle_.load(std::memory_order_acquire) & freshBit_) {
+		front_ = middle_.exchange(front_, std::memory_order_acq_rel) & indexMask_;
+	}
+	return buffers_[front_];
+}
+
+PersistentFile::PersistentFile(const string &path) : fd_{-1} {
+	fd_ = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+PersistentFile& PersistentFile::operator=(PersistentFile &&in){
+	if (this != &in) {
+		if (fd_ != -1) {
+			close(fd_);
+		}
+		fd_    = in.fd_;
+		in.fd_ = -1;
+	}
+	return *this;
+}
+
+PersistentFile::~PersistentFile(){
+	if (fd_ != -1) {
+		close(fd_);
+	}
+}
+
+size_t PersistentFile::read(char *buffer, const size_t &size) const {
+	if ( (fd_ == -1) || (size == 0) ) {
+		return 0;
+	}
+	ssize_t nRead;
+	while ( ( nRead = pread(fd_, buffer, size - 1, 0) ) == -1 ) {
+		if (errno != EINTR) {
+			nRead = 0;
+			break;
+		}
+	}
+	buffer[nRead] = '\0';
+	return static_cast<size_t>(nRead);
+}
+
+void RenderTrigger::notify(){
+	unique_lock<mutex> lk(mtx_);
+	pending_ = true;
+	nNotifications_++;
+	lk.unlock();
+	condition_.notify_one();
+}
+
+uint64_t RenderTrigger::wait(const milliseconds &window){
+	unique_lock<mutex> lk(mtx_);
+	condition_.wait(lk, [this]{ return pending_; });
+	if ( window.count() ) {
+		lk.unlock();
+		sleep_for(window);
+		lk.lock();
+	}
+	const uint64_t nServed = nNotifications_;
+	pending_               = false;
+	nNotifications_        = 0;
+	return nServed;
+}
+
 void Module::operator()() const {
-	if (refreshInterval_) { // if not zero, do a time-lapse loop
-		mutex mtx;
+	runModule_();
+	if (refreshInterval_ == 0) { // wait for a real-time signal
 		while (true) {
-			runModule_();
-			unique_lock<mutex> lk(mtx);
-			signalCondition_->wait_for(lk, seconds(refreshInterval_));
+			if ( waitForSignal_(-1) ) {
+				runModule_();
+			}
+		}
+	}
+	// deadlines are absolute, so the time it takes to run the module does not accumulate
+	// a real-time signal runs the module without moving the next deadline
+	if (alignToClock_) {
+		time_t deadline = nextAlignedTime_( system_clock::to_time_t( system_clock::now() ) );
+		while (true) {
+			while (true) {
+				const nanoseconds remaining = system_clock::from_time_t(deadline) - system_clock::now();
+				// the wait runs on the monotonic clock, so a deadline more than one interval away means that the wall clock was set back
+				if ( remaining > seconds(refreshInterval_) ) { // re-align and refresh, as the event loop does when its timer is cancelled
+					deadline = nextAlignedTime_( system_clock::to_time_t( system_clock::now() ) );
+					runModule_();
+					continue;
+				}
+				const int timeLeft = millisecondsLeft(remaining);
+				if (timeLeft <= 0) {
+					break;
+				}
+				if ( waitForSignal_(timeLeft) ) {
+					runModule_();
+				}
+			}
+			runModule_();
+			deadline = nextAlignedTime_( std::max( deadline, system_clock::to_time_t( system_clock::now() ) ) );
+		}
+	}
+	steady_clock::time_point deadline = steady_clock::now();
+	while (true) {
+		deadline += seconds(refreshInterval_);
+		const steady_clock::time_point now = steady_clock::now();
+		if (deadline < now) {  // the module ran past its next deadline; skip the missed refreshes
+			deadline = now;
+		}
+		int timeLeft;
+		while ( ( timeLeft = millisecondsLeft( deadline - steady_clock::now() ) ) > 0 ) {
+			if ( waitForSignal_(timeLeft) ) {
+				runModule_();
+			}
+		}
+		runModule_();
+	}
+}
+
+Module::~Module(){
+	if (eventFD_ != -1) {
+		close(eventFD_);
+	}
+	outSlot_       = nullptr;
+	outputTrigger_ = nullptr;
+}
+
+bool Module::waitForSignal_(const int &timeout) const {
+	// events on watched descriptors are handled while waiting
+	const steady_clock::time_point deadline = steady_clock::now() + milliseconds(timeout);
+	struct pollfd waitPoll[2];
+	waitPoll[0].fd     = signalFD_;   // poll() ignores negative descriptors, so this just sleeps if there is no signal
+	waitPoll[0].events = POLLIN;
+	waitPoll[1].fd     = eventFD_;
+	waitPoll[1].events = POLLIN;
+	int timeLeft = timeout;
+	while (true) {
+		waitPoll[0].revents = 0;
+		waitPoll[1].revents = 0;
+		const int pollRes   = poll(waitPoll, 2, timeLeft);
+		if (pollRes == 0) {
+			return false;
+		}
+		if (pollRes > 0) {
+			if (waitPoll[0].revents & POLLIN) {
+				uint64_t nSignals;
+				return read( signalFD_, &nSignals, sizeof(nSignals) ) == sizeof(nSignals);
+			}
+			if (waitPoll[1].revents & POLLIN) {
+				handleEvents_();
+			}
+		}
+		if (timeout >= 0) {
+			timeLeft = millisecondsLeft( deadline - steady_clock::now() );
+			if (timeLeft <= 0) {
+				return false;
+			}
+		}
+	}
+}
+
+void Module::makeEventFD_(){
+	eventFD_ = epoll_create1(EPOLL_CLOEXEC);
+}
+
+void Module::watchDescriptor_(const int &fd, const uint32_t &events) const {
+	struct epoll_event event;
+	event.events  = events;
+	event.data.fd = fd;
+	epoll_ctl(eventFD_, EPOLL_CTL_ADD, fd, &event);
+}
+
+void Module::unwatchDescriptor_(const int &fd) const {
+	epoll_ctl(eventFD_, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+void Module::handleEvents_() const {
+	const int maxEvents = 8;
+	struct epoll_event events[maxEvents];
+	const int nEvents = epoll_wait(eventFD_, events, maxEvents, 0);
+	if (nEvents == 0) { // some files clear their readiness when checked (e.g., /proc/self/mountinfo), so the event can be gone by now
+		processEvent_(-1, 0);
+		return;
+	}
+	for (int iEv = 0; iEv < nEvents; ++iEv) {
+		processEvent_(events[iEv].data.fd, events[iEv].events);
+	}
+}
+
+void Module::publish_(const string &output) const {
+	if ( outSlot_->write(output) ) { // no change, no need to wake the main thread
+		outputTrigger_->notify();
+	}
+}
+
+time_t Module::nextAlignedTime_(const time_t &now) const {
+	struct tm localNow;
+	localtime_r(&now, &localNow);
+	const time_t offset = localNow.tm_gmtoff; // align in local time, so that e.g. hourly refreshes happen on the hour in half-hour time zones
+	return ( (now + offset)/refreshInterval_ + 1 )*refreshInterval_ - offset;
+}
+
+void ModuleDate::runModule_() const {
+	time_t t = system_clock::to_time_t( system_clock::now() ); // time() uses a coarse clock that can lag behind an aligned refresh
+	stringstream outTime;
+	outTime << put_time( localtime(&t), dateFormat_.c_str() );
+	publish_( outTime.str() );
+}
+
+ModuleBattery::ModuleBattery(const uint32_t &interval, const string &powerSupplyRoot, const GlyphTable &glyphs, OutputSlot *output, RenderTrigger *trigger, const int &sigFD) : Module(interval, output, trigger, sigFD), glyphs_{&glyphs}, ueventFD_{-1} {
+	vector<string> deviceNames;
+	DIR *rootDir = opendir( powerSupplyRoot.c_str() );
+	if (rootDir != nullptr) { // fail silently
+		struct dirent *entry;
+		while ( ( entry = readdir(rootDir) ) != nullptr ) {
+			if (entry->d_name[0] != '.') {
+				deviceNames.push_back(entry->d_name);
+			}
+		}
+		closedir(rootDir);
+	}
+	std::sort( deviceNames.begin(), deviceNames.end() ); // directory order is arbitrary; keep BAT0 before BAT1
+	char buffer[32];
+	for (auto &name : deviceNames){
+		const string devicePath = powerSupplyRoot + "/" + name + "/";
+		PersistentFile typeFile(devicePath + "type");
+		typeFile.read( buffer, sizeof(buffer) );
+		if ( (strncmp(buffer, "Battery", 7) != 0) && (strncmp(buffer, "UPS", 3) != 0) ) {
+			continue;
+		}
+		PersistentFile scopeFile(devicePath + "scope");
+		if ( (scopeFile.read( buffer, sizeof(buffer) ) > 0) && (strncmp(buffer, "Device", 6) == 0) ) { // peripheral batteries do not power the system
+			continue;
+		}
+		addDevice_(devicePath);
+	}
+	outBuffer_.reserve(32);
+	ueventFD_ = openUeventSocket();
+	if (ueventFD_ != -1) {
+		makeEventFD_();
+		watchDescriptor_(ueventFD_, EPOLLIN);
+	}
+}
+
+ModuleBattery::~ModuleBattery(){
+	if (ueventFD_ != -1) {
+		close(ueventFD_);
+	}
+}
+
+void ModuleBattery::addDevice_(const string &devicePath){
+	statusFiles_.emplace_back(devicePath + "status");
+	PersistentFile energyFull(devicePath + "energy_full");
+	if ( energyFull.isOpen() ) {
+		nowFiles_.emplace_back(devicePath + "energy_now");
+		fullFiles_.push_back( std::move(energyFull) );
+		rateFiles_.emplace_back(devicePath + "power_now");
+		voltage_.push_back(0);
+		return;
+	}
+	PersistentFile chargeFull(devicePath + "charge_full");
+	if ( chargeFull.isOpen() ) {
+		// the voltage only converts charge to energy, so that devices with different units can be added up; read it once
+		uint64_t voltage = readUnsigned( PersistentFile(devicePath + "voltage_min_design") );
+		if (voltage == 0) {
+			voltage = readUnsigned( PersistentFile(devicePath + "voltage_now") );
+		}
+		nowFiles_.emplace_back(devicePath + "charge_now");
+		fullFiles_.push_back( std::move(chargeFull) );
+		rateFiles_.emplace_back(devicePath + "current_now");
+		voltage_.push_back(voltage == 0 ? 1 : voltage);
+		return;
+	}
+	nowFiles_.emplace_back(devicePath + "capacity"); // percent only; the device gets no weight in the energy totals
+	fullFiles_.emplace_back();
+	rateFiles_.emplace_back();
+	voltage_.push_back(0);
+}
+
+void ModuleBattery::processEvent_(const int &fd, const uint32_t &events) const {
+	if ( receiveUevents(ueventFD_, "SUBSYSTEM=power_supply") ) {
+		runModule_();
+	}
+}
+
+void ModuleBattery::runModule_() const {
+	if ( statusFiles_.empty() ) {
+		publish_("");
+		return;
+	}
+	// energies in microwatt-hours and power in microwatts, so that the totals do not overflow even when charge is converted using the voltage
+	uint64_t energyNow   = 0;
+	uint64_t energyFull  = 0;
+	uint64_t power       = 0;
+	uint64_t percentSum  = 0;
+	uint64_t nPercent    = 0;
+	bool charging        = false;
+	bool discharging     = false;
+	char status[32];
+	for (size_t iDev = 0; iDev < statusFiles_.size(); ++iDev) {
+		if (statusFiles_[iDev].read( status, sizeof(status) ) > 0) {
+			charging    = charging || (strncmp(status, "Charging", 8) == 0);
+			discharging = discharging || (strncmp(status, "Discharging", 11) == 0);
+		}
+		if ( !fullFiles_[iDev].isOpen() ) {
+			percentSum += readUnsigned(nowFiles_[iDev]);
+			++nPercent;
+			continue;
+		}
+		uint64_t now  = readUnsigned(nowFiles_[iDev]);
+		uint64_t full = readUnsigned(fullFiles_[iDev]);
+		uint64_t rate = readUnsigned(rateFiles_[iDev]);
+		if (voltage_[iDev]) {
+			now  = now*voltage_[iDev]/1000000;
+			full = full*voltage_[iDev]/1000000;
+			rate = rate*voltage_[iDev]/1000000;
+		}
+		energyNow  += now;
+		energyFull += full;
+		power      += rate;
+	}
+	uint64_t batCapacity = 0;
+	if (energyFull) {
+		batCapacity = std::min( (energyNow*100 + energyFull/2)/energyFull, static_cast<uint64_t>(100) );
+	} else if (nPercent) {
+		batCapacity = std::min( percentSum/nPercent, static_cast<uint64_t>(100) ); // keeps the glyph index in range
+	}
+	charging = charging && !discharging; // with two batteries, one can charge from the other while the system runs on battery
+	const size_t state = charging ? 2 : (discharging ? 0 : 1);
+	const char *glyph  = (*glyphs_)[state][batCapacity/5];
+	char output[64];
+	int length = snprintf(output, sizeof(output), "%u%% %s", static_cast<unsigned>(batCapacity), glyph);
+	// estimated time to empty or to full; the rate is zero or missing when the batteries are idle
+	uint64_t minutesLeft = 0;
+	if (power) {
+		if (discharging) {
+			minutesLeft = energyNow*60/power;
+		} else if ( charging && (energyFull > energyNow) ) {
+			minutesLeft = (energyFull - energyNow)*60/power;
+		}
+	}
+	if ( minutesLeft && (minutesLeft < 100*60) ) { // a nearly idle battery gives nonsensical estimates
+		length += snprintf(output + length, sizeof(output) - length, " %u:%02u", static_cast<unsigned>(minutesLeft/60), static_cast<unsigned>(minutesLeft%60));
+	}
+	outBuffer_.assign(output, static_cast<size_t>(length));
+	publish_(outBuffer_);
+}
+
+TemperatureSensors::TemperatureSensors(const string &hwmonRoot, const vector<string> &selection, const string &summary) : hwmonRoot_{hwmonRoot}, selection_{selection}, summary_{Summary::first} {
+	if (summary == "max") {
+		summary_ = Summary::max;
+	} else if (summary == "average") {
+		summary_ = Summary::average;
+	}
+	scan();
+}
+
+void TemperatureSensors::scan(){
+	inputFiles_.clear();
+	vector<string> chipDirs;
+	DIR *rootDir = opendir( hwmonRoot_.c_str() );
+	if (rootDir == nullptr) { // fail silently
+		return;
+	}
+	struct dirent *entry;
+	while ( ( entry = readdir(rootDir) ) != nullptr ) {
+		if (entry->d_name[0] != '.') {
+			chipDirs.push_back(entry->d_name);
+		}
+	}
+	closedir(rootDir);
+	std::sort( chipDirs.begin(), chipDirs.end() );
+	// the rank of a sensor is the index of the first selection entry it matches, so that sensors are kept in the order of the selection
+	vector< pair<size_t, string> > selected;
+	char buffer[64];
+	for (auto &chipDir : chipDirs){
+		const string chipPath = hwmonRoot_ + "/" + chipDir + "/";
+		if (PersistentFile(chipPath + "name").read( buffer, sizeof(buffer) ) == 0) {
+			continue;
+		}
+		const string chipName( buffer, strcspn(buffer, "\n") );
+		vector<uint64_t> sensorInds;
+		DIR *chipDirStream = opendir( chipPath.c_str() );
+		if (chipDirStream == nullptr) {
+			continue;
+		}
+		while ( ( entry = readdir(chipDirStream) ) != nullptr ) {
+			const size_t entryLength = strlen(entry->d_name);
+			if ( (entryLength > 10) && (strncmp(entry->d_name, "temp", 4) == 0) && (strcmp(entry->d_name + entryLength - 6, "_input") == 0) ) {
+				uint64_t sensorInd = 0;
+				parseUnsigned(entry->d_name + 4, entry->d_name + entryLength - 6, sensorInd);
+				sensorInds.push_back(sensorInd);
+			}
+		}
+		closedir(chipDirStream);
+		std::sort( sensorInds.begin(), sensorInds.end() ); // temp10 after temp9
+		for (auto &sensorInd : sensorInds){
+			const string attributePath = chipPath + "temp" + to_string(sensorInd);
+			string label;
+			if (PersistentFile(attributePath + "_label").read( buffer, sizeof(buffer) ) > 0) {
+				label.assign( buffer, strcspn(buffer, "\n") );
+			} else {
+				label = "temp" + to_string(sensorInd);
+			}
+			size_t rank = 0;
+			if ( !selection_.empty() ) {
+				const string sensorName = chipName + "/" + label;
+				rank = std::find_if( selection_.begin(), selection_.end(), [&](const string &sel){ return (sel == chipName) || (sel == sensorName); } ) - selection_.begin();
+				if ( rank == selection_.size() ) {
+					continue;
+				}
+			}
+			selected.emplace_back(rank, attributePath + "_input");
+		}
+	}
+	std::stable_sort( selected.begin(), selected.end(), [](const pair<size_t, string> &first, const pair<size_t, string> &second){ return first.first < second.first; } );
+	for (auto &sensor : selected){
+		inputFiles_.emplace_back(sensor.second);
+	}
+}
+
+bool TemperatureSensors::read(int64_t &temperature) const {
+	char buffer[32];
+	int64_t combined = 0;
+	int64_t nRead    = 0;
+	for (auto &file : inputFiles_){
+		const size_t length = file.read( buffer, sizeof(buffer) );
+		if (length == 0) { // drivers return an error for sensors that are absent or faulty
+			continue;
+		}
+		uint64_t magnitude = 0;
+		parseUnsigned(buffer, buffer + length, magnitude);
+		const int64_t value = (buffer[0] == '-' ? -static_cast<int64_t>(magnitude) : static_cast<int64_t>(magnitude) );
+		if (summary_ == Summary::first) {
+			temperature = value;
+			return true;
+		}
+		if (summary_ == Summary::max) {
+			combined = ( (nRead == 0) || (value > combined) ? value : combined );
+		} else {
+			combined += value;
+		}
+		++nRead;
+	}
+	if (nRead == 0) {
+		return false;
+	}
+	temperature = (summary_ == Summary::average ? combined/nRead : combined);
+	return true;
+}
+
+ModuleCPU::ModuleCPU(const uint32_t &interval, const string &hwmonRoot, const vector<string> &sensors, const string &summary, const uint32_t &hysteresis,
+		OutputSlot *output, RenderTrigger *trigger, const int &sigFD) : Module(interval, output, trigger, sigFD), hysteresis_{hysteresis}, ueventFD_{-1}, statFile_{"/proc/stat"},
+		sensors_(hwmonRoot, sensors, summary), previousTotalLoad_{0}, previousIdleLoad_{0}, thermalLevel_{0} {
+	outBuffer_.reserve(64);
+	ueventFD_ = openUeventSocket();
+	if (ueventFD_ != -1) {
+		makeEventFD_();
+		watchDescriptor_(ueventFD_, EPOLLIN);
+	}
+}
+
+ModuleCPU::~ModuleCPU(){
+	if (ueventFD_ != -1) {
+		close(ueventFD_);
+	}
+}
+
+void ModuleCPU::processEvent_(const int &fd, const uint32_t &events) const {
+	if ( receiveUevents(ueventFD_, "SUBSYSTEM=hwmon") ) {
+		sensors_.scan();
+		runModule_();
+	}
+}
+
+void ModuleCPU::runModule_() const{
+	char buffer[256];  // enough for the first (aggregate) line of /proc/stat
+	// the CPU usage data in this file are cumulative, so I must keep the values from the previous iteration (previous*_ private members)
+	// I then subtract these previous values to get the data for the measurement interval
+	float percentLoad = 0.0;
+	const size_t statSize = statFile_.read( buffer, sizeof(buffer) );
+	if (statSize > 4) {   // fail silently
+		const char *end    = buffer + statSize;
+		const char *pos    = buffer + 4; // skip the "cpu " line name
+		uint64_t curTotalLoad = 0;
+		uint64_t curIdleLoad  = 0;
+		// user, nice, system, idle, iowait, irq, softirq, steal; guest time that follows is already counted in user and nice
+		for (uint16_t fInd = 1; fInd <= 8; ++fInd) {
+			uint64_t field = 0;
+			pos = parseUnsigned(pos, end, field);
+			if ( (fInd == 4) || (fInd == 5) ) {
+				curIdleLoad += field;
+			}
+			curTotalLoad += field;
+		}
+		if (curTotalLoad > previousTotalLoad_) {
+			// iowait can decrease between reads (see proc(5)), so the idle time can go down
+			const uint64_t idleDiff  = (curIdleLoad > previousIdleLoad_ ? curIdleLoad - previousIdleLoad_ : 0);
+			const uint64_t totalDiff = curTotalLoad - previousTotalLoad_;
+			percentLoad = ( 1.0 - static_cast<double>( std::min(idleDiff, totalDiff) )/static_cast<double>(totalDiff) )*100.0;
+		}
+		previousIdleLoad_  = curIdleLoad;
+		previousTotalLoad_ = curTotalLoad;
+	}
+	int64_t cpuTemp = 0;
+	if ( !sensors_.read(cpuTemp) ) { // fail silently; show the load only
+		const int outSize = snprintf(buffer, sizeof(buffer), "\ufb19 %.1f%%", percentLoad);
+		outBuffer_.assign( buffer, static_cast<size_t>(outSize) );
+		publish_(outBuffer_);
+		return;
+	}
+	cpuTemp /= 1000;
+	updateThermalLevel(cpuTemp, hysteresis_, thermalLevel_);
+	const int outSize = snprintf(buffer, sizeof(buffer), "\ufb19 %.1f%% %s %d°C", percentLoad, thermalGlyphs[thermalLevel_], static_cast<int>(cpuTemp));
+	outBuffer_.assign( buffer, static_cast<size_t>(outSize) );
+	publish_(outBuffer_);
+}
+
+// static members
+const char *ModuleCPUCores::heatGlyphs_[] = {"\u2581", "\u2582", "\u2583", "\u2584", "\u2585", "\u2586", "\u2587", "\u2588"};
+const size_t ModuleCPUCores::nHeatGlyphs_ = 8;
+
+ModuleCPUCores::ModuleCPUCores(const uint32_t &interval, const uint32_t &nTop, OutputSlot *output, RenderTrigger *trigger, const int &sigFD) : Module(interval, output, trigger, sigFD), nTop_{nTop}, statFile_{"/proc/stat"} {
+	const long confCores = sysconf(_SC_NPROCESSORS_CONF);
+	const size_t nCores  = (confCores > 0 ? static_cast<size_t>(confCores) : 1);
+	// a CPU line has at most 10 fields of up to 20 digits each; only the CPU lines at the start of the file are read
+	statBuffer_.resize( (nCores + 1)*256 );
+	idle_.resize(nCores, 0);
+	total_.resize(nCores, 0);
+	previousIdle_.resize(nCores, 0);
+	previousTotal_.resize(nCores, 0);
+	load_.resize(nCores, 0.0);
+	coreOrder_.resize(nCores);
+	for (uint32_t iCore = 0; iCore < nCores; ++iCore) {
+		coreOrder_[iCore] = iCore;
+	}
+	outBuffer_.reserve(nTop_ ? 16*nTop_ + 8 : 3*nCores + 8);
+	// start from the current counters, so that the first difference covers one interval rather than the time since boot
+	if ( readCounters_() ) {
+		previousIdle_  = idle_;
+		previousTotal_ = total_;
+	}
+}
+
+bool ModuleCPUCores::readCounters_() const {
+	const size_t statSize = statFile_.read( statBuffer_.data(), statBuffer_.size() );
+	if (statSize == 0) {
+		return false;
+	}
+	const char *end = statBuffer_.data() + statSize;
+	const char *pos = static_cast<const char*>( memchr(statBuffer_.data(), '\n', statSize) ); // skip the aggregate line
+	while ( (pos != nullptr) && (end - pos > 4) && (pos[1] == 'c') && (pos[2] == 'p') && (pos[3] == 'u') ) {
+		uint64_t coreInd = 0;
+		pos = parseUnsigned(pos + 4, end, coreInd);
+		uint64_t coreIdle  = 0;
+		uint64_t coreTotal = 0;
+		// user, nice, system, idle, iowait, irq, softirq, steal; guest time that follows is already counted in user and nice
+		for (uint16_t fInd = 1; fInd <= 8; ++fInd) {
+			uint64_t field = 0;
+			pos = parseUnsigned(pos, end, field);
+			coreIdle  += ( (fInd == 4) || (fInd == 5) ? field : 0 );
+			coreTotal += field;
+		}
+		if ( coreInd < idle_.size() ) {
+			idle_[coreInd]  = coreIdle;
+			total_[coreInd] = coreTotal;
+		}
+		pos = static_cast<const char*>( memchr(pos, '\n', static_cast<size_t>(end - pos)) );
+	}
+	return true;
+}
+
+void ModuleCPUCores::runModule_() const {
+	if ( !readCounters_() ) { // fail silently
+		return;
+	}
+	const size_t nCores     = load_.size();
+	const uint64_t *idle    = idle_.data();
+	const uint64_t *total   = total_.data();
+	uint64_t *previousIdle  = previousIdle_.data();
+	uint64_t *previousTotal = previousTotal_.data();
+	float *load             = load_.data();
+	// branch-free loops over contiguous arrays, so that they are vectorized
+	// the differences over one interval (including the first, thanks to the counters read in the constructor) fit in 32 bits; converting signed 32-bit integers to float is a vector instruction with AVX2, while 64-bit and unsigned conversions need AVX-512
+	for (size_t iCore = 0; iCore < nCores; ++iCore) {
+		// iowait can decrease between reads (see proc(5)), so the counters can go down; the difference is then negative after narrowing and counts as 0
+		const int32_t totalDiff = std::max(static_cast<int32_t>(total[iCore] - previousTotal[iCore]), 0);
+		const int32_t idleDiff  = std::max(static_cast<int32_t>(idle[iCore] - previousIdle[iCore]), 0);
+		const int32_t busyDiff  = std::max(totalDiff - idleDiff, 0);
+		load[iCore] = static_cast<float>(busyDiff)/static_cast<float>( totalDiff + (totalDiff == 0) );
+	}
+	for (size_t iCore = 0; iCore < nCores; ++iCore) {
+		previousIdle[iCore]  = idle[iCore];
+		previousTotal[iCore] = total[iCore];
+	}
+	char buffer[32];
+	outBuffer_.assign("\ufb19 ");
+	if (nTop_ == 0) {
+		for (size_t iCore = 0; iCore < nCores; ++iCore) {
+			const size_t glyphInd = std::min( static_cast<size_t>(load[iCore]*static_cast<float>(nHeatGlyphs_)), nHeatGlyphs_ - 1 );
+			outBuffer_ += heatGlyphs_[glyphInd];
+		}
+	} else {
+		const size_t nShow = std::min(static_cast<size_t>(nTop_), nCores);
+		std::partial_sort(coreOrder_.begin(), coreOrder_.begin() + nShow, coreOrder_.end(),
+				[load](const uint32_t &first, const uint32_t &second){ return load[first] > load[second]; });
+		for (size_t iShow = 0; iShow < nShow; ++iShow) {
+			const int outSize = snprintf(buffer, sizeof(buffer), (iShow ? " %u:%.0f%%" : "%u:%.0f%%"), coreOrder_[iShow], load[coreOrder_[iShow]]*100.0);
+			outBuffer_.append( buffer, static_cast<size_t>(outSize) );
+		}
+	}
+	publish_(outBuffer_);
+}
+
+ModuleRAM::ModuleRAM(const uint32_t &interval, const vector< vector<string> > &fields, OutputSlot *output, RenderTrigger *trigger, const int &sigFD) : Module(interval, output, trigger, sigFD), memInfoFile_{"/proc/meminfo"} {
+	size_t labelLength = 0;
+	for (auto &field : fields){
+		if (field.size() < 2) { // ignore malformed fields silently
+			continue;
+		}
+		keys_.push_back(field[0] + ":");
+		labels_.push_back(field[1]);
+		labelLength += field[1].size();
+	}
+	values_.resize(keys_.size(), 0);
+	found_.resize(keys_.size(), 0);
+	outBuffer_.reserve( labelLength + 16*keys_.size() );
+}
+
+void ModuleRAM::runModule_() const {
+	char buffer[8192]; // /proc/meminfo is about 1.5 kB
+	const size_t memInfoSize = memInfoFile_.read( buffer, sizeof(buffer) );
+	if (memInfoSize == 0) { // fail silently
+		publish_("");
+		return;
+	}
+	std::fill(found_.begin(), found_.end(), 0);
+	size_t nFound = 0;
+	const char *end = buffer + memInfoSize;
+	const char *pos = buffer;
+	while ( (pos < end) && ( nFound < keys_.size() ) ) {
+		const char *lineEnd = static_cast<const char*>( memchr(pos, '\n', static_cast<size_t>(end - pos)) );
+		if (lineEnd == nullptr) {
+			lineEnd = end;
+		}
+		for (size_t iKey = 0; iKey < keys_.size(); ++iKey) {
+			const size_t keyLength = keys_[iKey].size();
+			if ( !found_[iKey] && (static_cast<size_t>(lineEnd - pos) > keyLength) && (memcmp(pos, keys_[iKey].data(), keyLength) == 0) ) {
+				parseUnsigned(pos + keyLength, lineEnd, values_[iKey]);
+				found_[iKey] = 1;
+				++nFound;
+				break;
+			}
+		}
+		pos = lineEnd + 1;
+	}
+	outBuffer_.clear();
+	char number[32];
+	for (size_t iKey = 0; iKey < keys_.size(); ++iKey) {
+		if (!found_[iKey]) { // e.g., zswap fields on kernels without zswap
+			continue;
+		}
+		// the values in the file are in KiB
+		int length;
+		if (values_[iKey] < 1048576) {
+			length = snprintf(number, sizeof(number), "%uMi", static_cast<unsigned>( (values_[iKey] + 512)/1024 ));
+		} else {
+			const uint64_t tenthsGi = (values_[iKey]*10 + 524288)/1048576;
+			length = snprintf(number, sizeof(number), "%llu.%uGi", static_cast<unsigned long long>(tenthsGi/10), static_cast<unsigned>(tenthsGi%10));
+		}
+		if ( !outBuffer_.empty() ) {
+			outBuffer_ += ' ';
+		}
+		outBuffer_ += labels_[iKey];
+		outBuffer_.append(number, static_cast<size_t>(length));
+	}
+	publish_(outBuffer_);
+}
+
+ModuleNet::ModuleNet(const uint32_t &interval, const string &netClassRoot, const vector<string> &interfaces, OutputSlot *output, RenderTrigger *trigger, const int &sigFD) : Module(interval, output, trigger, sigFD), allInterfaces_{interfaces.empty()}, netClassRoot_{netClassRoot}, netDevFile_{"/proc/net/dev"}, interfaces_{interfaces}, previousTime_{steady_clock::now()} {
+	counted_.resize(interfaces_.size(), 1);
+	previousRx_.resize(interfaces_.size(), 0);
+	previousTx_.resize(interfaces_.size(), 0);
+	sampled_.resize(interfaces_.size(), 0);
+	present_.resize(interfaces_.size(), 0);
+	outBuffer_.reserve(32);
+}
+
+void ModuleNet::runModule_() const {
+	const size_t netDevSize = readWholeFile(netDevFile_, netDevBuffer_);
+	const steady_clock::time_point now = steady_clock::now();
+	const double elapsed = std::chrono::duration<double>(now - previousTime_).count();
+	previousTime_        = now;
+	uint64_t rxBytes     = 0;
+	uint64_t txBytes     = 0;
+	std::fill(present_.begin(), present_.end(), 0);
+	const char *end = netDevBuffer_.data() + netDevSize;
+	const char *pos = netDevBuffer_.data();
+	while (pos < end) {
+		const char *lineEnd = static_cast<const char*>( memchr(pos, '\n', static_cast<size_t>(end - pos)) );
+		if (lineEnd == nullptr) {
+			lineEnd = end;
+		}
+		// interface lines are "name: rx_bytes rx_packets (6 more receive fields) tx_bytes ..."; the two header lines have no colon
+		const char *colon = static_cast<const char*>( memchr(pos, ':', static_cast<size_t>(lineEnd - pos)) );
+		if (colon != nullptr) {
+			const char *name = pos;
+			while ( (name < colon) && (*name == ' ') ) {
+				++name;
+			}
+			const size_t nameLength = static_cast<size_t>(colon - name);
+			size_t ifInd = 0;
+			while ( ( ifInd < interfaces_.size() ) && ( (interfaces_[ifInd].size() != nameLength) || (memcmp(interfaces_[ifInd].data(), name, nameLength) != 0) ) ) {
+				++ifInd;
+			}
+			if ( ( ifInd == interfaces_.size() ) && allInterfaces_ ) {
+				interfaces_.emplace_back(name, nameLength);
+				// only physical interfaces have a device link; loopback, bridges, veth pairs, and tunnels do not
+				counted_.push_back( access( (netClassRoot_ + "/" + interfaces_.back() + "/device").c_str(), F_OK ) == 0 );
+				previousRx_.push_back(0);
+				previousTx_.push_back(0);
+				sampled_.push_back(0);
+				present_.push_back(0);
+			}
+			if ( ifInd < interfaces_.size() ) {
+				present_[ifInd] = 1;
+			}
+			if ( ( ifInd < interfaces_.size() ) && counted_[ifInd] ) {
+				uint64_t rx = 0;
+				uint64_t tx = 0;
+				const char *field = parseUnsigned(colon + 1, lineEnd, rx);
+				for (uint16_t fInd = 1; fInd <= 8; ++fInd) {
+					field = parseUnsigned(field, lineEnd, tx);
+				}
+				if (sampled_[ifInd]) {
+					rxBytes += counterDifference(rx, previousRx_[ifInd]);
+					txBytes += counterDifference(tx, previousTx_[ifInd]);
+				}
+				previousRx_[ifInd] = rx;
+				previousTx_[ifInd] = tx;
+				sampled_[ifInd]    = 1;
+			}
+		}
+		pos = lineEnd + 1;
+	}
+	if ( allInterfaces_ && (netDevSize > 0) ) {
+		// forget interfaces that are gone (e.g., veth pairs of stopped containers), so that the lists do not grow and a re-used name is checked again
+		size_t nKept = 0;
+		for (size_t ifInd = 0; ifInd < interfaces_.size(); ++ifInd) {
+			if (!present_[ifInd]) {
+				continue;
+			}
+			if (nKept != ifInd) {
+				interfaces_[nKept].swap(interfaces_[ifInd]);
+				counted_[nKept]    = counted_[ifInd];
+				previousRx_[nKept] = previousRx_[ifInd];
+				previousTx_[nKept] = previousTx_[ifInd];
+				sampled_[nKept]    = sampled_[ifInd];
+			}
+			++nKept;
+		}
+		interfaces_.resize(nKept);
+		counted_.resize(nKept);
+		previousRx_.resize(nKept);
+		previousTx_.resize(nKept);
+		sampled_.resize(nKept);
+		present_.resize(nKept);
+	}
+	if (netDevSize == 0) { // fail silently
+		publish_("");
+		return;
+	}
+	char buffer[64];
+	int length = snprintf(buffer, sizeof(buffer), "\uf063 ");
+	length += formatRate( (elapsed > 0.0 ? static_cast<double>(rxBytes)/elapsed : 0.0), buffer + length, sizeof(buffer) - length );
+	length += snprintf(buffer + length, sizeof(buffer) - length, " \uf062 ");
+	length += formatRate( (elapsed > 0.0 ? static_cast<double>(txBytes)/elapsed : 0.0), buffer + length, sizeof(buffer) - length );
+	outBuffer_.assign( buffer, static_cast<size_t>(length) );
+	publish_(outBuffer_);
+}
+
+ModuleWifi::ModuleWifi(const uint32_t &interval, const string &interface, const LevelTable &levels, const BarTable &bars, const string &disconnected, OutputSlot *output, RenderTrigger *trigger, const int &sigFD) : Module(interval, output, trigger, sigFD), levels_{&levels}, bars_{&bars}, disconnected_{disconnected}, wirelessFile_{"/proc/net/wireless"}, interface_{interface}, ifIndex_{0}, familyID_{0}, requestFD_{-1}, notifyFD_{-1}, sequence_{1} {
+	outBuffer_.reserve(64);
+	requestFD_ = openGenericNetlink();
+	if (requestFD_ == -1) { // fail silently; the signal level is still shown
+		return;
+	}
+	uint32_t mlmeGroup = 0;
+	familyID_ = resolveGenericFamily(requestFD_, NL80211_GENL_NAME, NL80211_MULTICAST_GROUP_MLME, mlmeGroup);
+	if (familyID_ == 0) {
+		return;
+	}
+	if (mlmeGroup != 0) {
+		notifyFD_ = openGenericNetlink();
+		if ( (notifyFD_ != -1) && (setsockopt( notifyFD_, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &mlmeGroup, sizeof(mlmeGroup) ) == 0) ) {
+			makeEventFD_();
+			watchDescriptor_(notifyFD_, EPOLLIN);
+		}
+	}
+	updateSSID_();
+}
+
+ModuleWifi::~ModuleWifi(){
+	if (requestFD_ != -1) {
+		close(requestFD_);
+	}
+	if (notifyFD_ != -1) {
+		close(notifyFD_);
+	}
+}
+
+bool ModuleWifi::findInterface_() const {
+	if (ifIndex_ != 0) {
+		return true;
+	}
+	if ( interface_.empty() ) {
+		char buffer[4096];
+		const size_t wirelessSize = wirelessFile_.read( buffer, sizeof(buffer) );
+		// the first two lines are headers
+		const char *name = static_cast<const char*>( memchr(buffer, '\n', wirelessSize) );
+		name             = ( name == nullptr ? nullptr : static_cast<const char*>( memchr(name + 1, '\n', static_cast<size_t>(buffer + wirelessSize - name - 1)) ) );
+		if (name == nullptr) {
+			return false;
+		}
+		++name;
+		while ( (name < buffer + wirelessSize) && (*name == ' ') ) {
+			++name;
+		}
+		const char *colon = static_cast<const char*>( memchr(name, ':', static_cast<size_t>(buffer + wirelessSize - name)) );
+		if (colon == nullptr) {
+			return false;
+		}
+		interface_.assign(name, colon);
+	}
+	ifIndex_ = if_nametoindex( interface_.c_str() );
+	return ifIndex_ != 0;
+}
+
+void ModuleWifi::updateSSID_() const {
+	ssid_.clear();
+	if ( (familyID_ == 0) || !findInterface_() ) {
+		return;
+	}
+	++sequence_;
+	if ( !sendGenericRequest(requestFD_, familyID_, NL80211_CMD_GET_INTERFACE, NL80211_ATTR_IFINDEX, &ifIndex_, sizeof(ifIndex_), sequence_) ) {
+		return;
+	}
+	alignas(struct nlmsghdr) char buffer[8192];
+	const struct nlmsghdr *reply = receiveGenericReply( requestFD_, sequence_, buffer, sizeof(buffer) );
+	if (reply == nullptr) {
+		ifIndex_ = 0; // the interface may have been re-created with a new index
+		return;
+	}
+	const struct nlattr *ssid = findAttribute(reinterpret_cast<const char*>(reply) + NLMSG_HDRLEN + GENL_HDRLEN, reinterpret_cast<const char*>(reply) + reply->nlmsg_len, NL80211_ATTR_SSID);
+	if (ssid != nullptr) { // the SSID attribute is present only while the interface is connected
+		ssid_.assign(reinterpret_cast<const char*>(ssid) + NLA_HDRLEN, ssid->nla_len - NLA_HDRLEN);
+	}
+}
+
+void ModuleWifi::processEvent_(const int &fd, const uint32_t &events) const {
+	alignas(struct nlmsghdr) char buffer[8192];
+	bool changed = false;
+	while (true) {
+		const ssize_t nReceived = recv(notifyFD_, buffer, sizeof(buffer), 0);
+		if (nReceived <= 0) {
+			if (nReceived == -1) {
+				if (errno == EINTR) {
+					continue;
+				}
+				changed = changed || (errno == ENOBUFS); // notifications were lost
+			}
+			break;
+		}
+		int length = static_cast<int>(nReceived);
+		for (const struct nlmsghdr *message = reinterpret_cast<const struct nlmsghdr*>(buffer); NLMSG_OK(message, length); message = NLMSG_NEXT(message, length)) {
+			if (message->nlmsg_type != familyID_) {
+				continue;
+			}
+			const struct genlmsghdr *genericHeader = static_cast<const struct genlmsghdr*>( NLMSG_DATA(message) );
+			switch (genericHeader->cmd) {
+				case NL80211_CMD_CONNECT:
+				case NL80211_CMD_DISCONNECT:
+				case NL80211_CMD_ROAM:
+				case NL80211_CMD_DISASSOCIATE:
+				case NL80211_CMD_DEAUTHENTICATE: {
+					const struct nlattr *ifIndexAttr = findAttribute(reinterpret_cast<const char*>(message) + NLMSG_HDRLEN + GENL_HDRLEN, reinterpret_cast<const char*>(message) + message->nlmsg_len, NL80211_ATTR_IFINDEX);
+					uint32_t eventIfIndex = 0;
+					if (ifIndexAttr != nullptr) {
+						memcpy( &eventIfIndex, reinterpret_cast<const char*>(ifIndexAttr) + NLA_HDRLEN, sizeof(eventIfIndex) );
+					}
+					changed = changed || (ifIndex_ == 0) || (eventIfIndex == 0) || (eventIfIndex == ifIndex_);
+					break;
+				}
+				default:
+					break;
+			}
+		}
+	}
+	if (changed) {
+		updateSSID_();
+		runModule_();
+	}
+}
+
+void ModuleWifi::runModule_() const {
+	if ( (familyID_ != 0) && ssid_.empty() && (ifIndex_ == 0) ) { // the interface did not exist yet when the SSID was last requested
+		updateSSID_();
+	}
+	char buffer[4096];
+	const size_t wirelessSize = ( interface_.empty() && !findInterface_() ) ? 0 : wirelessFile_.read( buffer, sizeof(buffer) );
+	// interface lines are "name: status link. level. noise. ..."
+	const char *end  = buffer + wirelessSize;
+	const char *line = buffer;
+	const char *pos  = nullptr;
+	while (line < end) {
+		const char *lineEnd = static_cast<const char*>( memchr(line, '\n', static_cast<size_t>(end - line)) );
+		if (lineEnd == nullptr) {
+			lineEnd = end;
+		}
+		const char *name = line;
+		while ( (name < lineEnd) && (*name == ' ') ) {
+			++name;
+		}
+		if ( ( static_cast<size_t>(lineEnd - name) > interface_.size() ) && (memcmp( name, interface_.data(), interface_.size() ) == 0) && (name[interface_.size()] == ':') ) {
+			pos = name + interface_.size() + 1;
+			end = lineEnd;
+			break;
+		}
+		line = lineEnd + 1;
+	}
+	if ( (pos == nullptr) || ( (familyID_ != 0) && ssid_.empty() ) ) {
+		publish_(disconnected_);
+		return;
+	}
+	for (uint16_t iField = 0; iField < 2; ++iField) { // skip the status and link quality
+		while ( (pos < end) && (*pos == ' ') ) {
+			++pos;
+		}
+		while ( (pos < end) && (*pos != ' ') ) {
+			++pos;
+		}
+	}
+	while ( (pos < end) && (*pos == ' ') ) {
+		++pos;
+	}
+	const bool negative = (pos < end) && (*pos == '-');
+	uint64_t magnitude  = 0;
+	parseUnsigned(pos, end, magnitude);
+	int32_t level = ( negative ? -static_cast<int32_t>(magnitude) : static_cast<int32_t>(magnitude) );
+	if (level > 0) { // some drivers report the level in dBm as an unsigned byte
+		level -= 256;
+	}
+	const size_t barInd = static_cast<size_t>( (level <= (*levels_)[0]) + (level <= (*levels_)[1]) + (level <= (*levels_)[2]) );
+	outBuffer_ = ssid_;
+	if ( !outBuffer_.empty() ) {
+		outBuffer_ += ' ';
+	}
+	const int length = snprintf( buffer, sizeof(buffer), "%d ", static_cast<int>(level) );
+	outBuffer_.append( buffer, static_cast<size_t>(length) );
+	outBuffer_ += (*bars_)[barInd];
+	publish_(outBuffer_);
+}
+
+ModuleMail::ModuleMail(const uint32_t &interval, const string &mailRoot, const string &folderName, const string &glyph, OutputSlot *output, RenderTrigger *trigger, const int &sigFD) : Module(interval, output, trigger, sigFD), glyph_{glyph}, inotifyFD_{-1} {
+	string root = mailRoot;
+	if (root.compare(0, 2, "~/") == 0) {
+		const char *home = getenv("HOME");
+		root.replace( 0, 1, (home == nullptr ? "" : home) );
+	}
+	findFolders_(root, folderName);
+	inotifyFD_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotifyFD_ != -1) {
+		makeEventFD_();
+		watchDescriptor_(inotifyFD_, EPOLLIN);
+	}
+	// watches are added before the messages are counted in the first run, so that no delivery is missed in between
+	for (auto &directory : newDirectories_){
+		watches_.push_back( inotifyFD_ == -1 ? -1 : inotify_add_watch(inotifyFD_, directory.c_str(), IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM | IN_ONLYDIR) );
+	}
+	counts_.resize(newDirectories_.size(), 0);
+	outBuffer_.reserve( 16 + glyph_.size() );
+}
+
+ModuleMail::~ModuleMail(){
+	if (inotifyFD_ != -1) {
+		close(inotifyFD_);
+	}
+}
+
+void ModuleMail::findFolders_(const string &directory, const string &folderName){
+	DIR *dir = opendir( directory.c_str() );
+	if (dir == nullptr) { // fail silently
+		return;
+	}
+	vector<string> subdirectories;
+	struct dirent *entry;
+	while ( ( entry = readdir(dir) ) != nullptr ) {
+		if (entry->d_name[0] == '.') {
+			continue;
+		}
+		const string path = directory + "/" + entry->d_name;
+		bool isDirectory  = (entry->d_type == DT_DIR);
+		if (entry->d_type == DT_UNKNOWN) { // some file systems do not report the entry type
+			struct stat status;
+			isDirectory = (lstat(path.c_str(), &status) == 0) && S_ISDIR(status.st_mode);
+		}
+		if (!isDirectory) {
+			continue;
+		}
+		if (folderName == entry->d_name) {
+			struct stat status;
+			if ( (stat( (path + "/new").c_str(), &status ) == 0) && S_ISDIR(status.st_mode) ) {
+				newDirectories_.push_back(path + "/new");
+				continue;
+			}
+		}
+		// message directories of a maildir hold only files
+		if ( (strcmp(entry->d_name, "cur") != 0) && (strcmp(entry->d_name, "new") != 0) && (strcmp(entry->d_name, "tmp") != 0) ) {
+			subdirectories.push_back(path);
+		}
+	}
+	closedir(dir);
+	for (auto &subdirectory : subdirectories){
+		findFolders_(subdirectory, folderName);
+	}
+}
+
+void ModuleMail::publishCount_() const {
+	uint64_t total = 0;
+	for (auto &count : counts_){
+		total += count;
+	}
+	if (total == 0) {
+		publish_("");
+		return;
+	}
+	char number[32];
+	const int length = snprintf( number, sizeof(number), "%llu", static_cast<unsigned long long>(total) );
+	outBuffer_.assign( number, static_cast<size_t>(length) );
+	outBuffer_ += glyph_;
+	publish_(outBuffer_);
+}
+
+void ModuleMail::runModule_() const {
+	for (size_t iDir = 0; iDir < newDirectories_.size(); ++iDir) {
+		counts_[iDir] = countEntries(newDirectories_[iDir]);
+	}
+	publishCount_();
+}
+
+void ModuleMail::processEvent_(const int &fd, const uint32_t &events) const {
+	alignas(struct inotify_event) char buffer[4096];
+	bool recount = false;
+	while (true) {
+		const ssize_t nRead = read( inotifyFD_, buffer, sizeof(buffer) );
+		if (nRead <= 0) {
+			if ( (nRead == -1) && (errno == EINTR) ) {
+				continue;
+			}
+			break;
+		}
+		for (const char *pos = buffer; pos < buffer + nRead; ) {
+			const struct inotify_event *event = reinterpret_cast<const struct inotify_event*>(pos);
+			pos += sizeof(struct inotify_event) + event->len;
+			if (event->mask & IN_Q_OVERFLOW) { // events were lost
+				recount = true;
+				continue;
+			}
+			if ( (event->mask & IN_ISDIR) || (event->len == 0) || (event->name[0] == '.') ) {
+				continue;
+			}
+			const size_t dirInd = static_cast<size_t>( std::find(watches_.begin(), watches_.end(), event->wd) - watches_.begin() );
+			if ( dirInd == watches_.size() ) {
+				continue;
+			}
+			if ( event->mask & (IN_CREATE | IN_MOVED_TO) ) {
+				++counts_[dirInd];
+			} else if ( event->mask & (IN_DELETE | IN_MOVED_FROM) ) {
+				if (counts_[dirInd] == 0) { // out of step with the directory
+					recount = true;
+				} else {
+					--counts_[dirInd];
+				}
+			}
+		}
+	}
+	if (recount) {
+		runModule_();
+	} else {
+		publishCount_();
+	}
+}
+
+ModulePacman::ModulePacman(const uint32_t &interval, const string &dbRoot, const vector<string> &repositories, const vector<string> &ignored, const string &glyph,
+		OutputSlot *output, RenderTrigger *trigger, const int &sigFD) : Module(interval, output, trigger, sigFD), localPath_{dbRoot + "/local"}, syncPath_{dbRoot + "/sync"}, repositories_{repositories},
+		ignored_{ignored}, glyph_{glyph}, inotifyFD_{-1}, localWatch_{-1}, syncWatch_{-1} {
+	if ( repositories_.empty() ) {
+		DIR *syncDir = opendir( syncPath_.c_str() );
+		if (syncDir != nullptr) { // fail silently
+			struct dirent *entry;
+			while ( ( entry = readdir(syncDir) ) != nullptr ) {
+				const size_t nameLength = strlen(entry->d_name);
+				if ( (nameLength > 3) && (strcmp(entry->d_name + nameLength - 3, ".db") == 0) ) {
+					repositories_.emplace_back(entry->d_name, nameLength - 3);
+				}
+			}
+			closedir(syncDir);
+		}
+		std::sort( repositories_.begin(), repositories_.end() );
+	}
+	syncVersions_.resize( repositories_.size() );
+	inotifyFD_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotifyFD_ != -1) {
+		makeEventFD_();
+		watchDescriptor_(inotifyFD_, EPOLLIN);
+		// pacman adds and removes a directory for each installed package
+		localWatch_ = inotify_add_watch(inotifyFD_, localPath_.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM | IN_ONLYDIR);
+		// sync databases are either written in place or downloaded to a temporary file and renamed
+		syncWatch_  = inotify_add_watch(inotifyFD_, syncPath_.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR);
+	}
+	outBuffer_.reserve( 16 + glyph_.size() );
+}
+
+ModulePacman::~ModulePacman(){
+	if (inotifyFD_ != -1) {
+		close(inotifyFD_);
+	}
+}
+
+void ModulePacman::indexLocal_() const {
+	localVersions_.clear();
+	DIR *localDir = opendir( localPath_.c_str() );
+	if (localDir == nullptr) { // fail silently
+		return;
+	}
+	string name;
+	string version;
+	struct dirent *entry;
+	while ( ( entry = readdir(localDir) ) != nullptr ) {
+		// the database also holds a version file; package entries are directories
+		if ( (entry->d_name[0] != '.') && ( (entry->d_type == DT_DIR) || (entry->d_type == DT_UNKNOWN) ) && splitPackageEntry( entry->d_name, strlen(entry->d_name), name, version ) ) {
+			localVersions_[name] = version;
+		}
+	}
+	closedir(localDir);
+}
+
+void ModulePacman::indexRepository_(const size_t &repoInd) const {
+	readSyncDatabase(syncPath_ + "/" + repositories_[repoInd] + ".db", syncVersions_[repoInd]);
+}
+
+void ModulePacman::publishCount_() const {
+	uint32_t nUpdates = 0;
+	for (auto &package : localVersions_){
+		if ( std::find(ignored_.begin(), ignored_.end(), package.first) != ignored_.end() ) {
+			continue;
+		}
+		// the first repository that has the package provides the update, as in pacman
+		for (auto &repository : syncVersions_){
+			const auto available = repository.find(package.first);
+			if ( available != repository.end() ) {
+				nUpdates += (compareVersions(available->second, package.second) > 0 ? 1 : 0);
+				break;
+			}
+		}
+	}
+	if (nUpdates == 0) {
+		publish_("");
+		return;
+	}
+	char number[32];
+	const int length = snprintf( number, sizeof(number), "%u", static_cast<unsigned>(nUpdates) );
+	outBuffer_.assign( number, static_cast<size_t>(length) );
+	outBuffer_ += glyph_;
+	publish_(outBuffer_);
+}
+
+void ModulePacman::runModule_() const {
+	indexLocal_();
+	for (size_t iRepo = 0; iRepo < repositories_.size(); ++iRepo) {
+		indexRepository_(iRepo);
+	}
+	publishCount_();
+}
+
+void ModulePacman::processEvent_(const int &fd, const uint32_t &events) const {
+	alignas(struct inotify_event) char buffer[4096];
+	vector<char> staleRepositories(repositories_.size(), 0);
+	bool changed = false;
+	string name;
+	string version;
+	while (true) {
+		const ssize_t nRead = read( inotifyFD_, buffer, sizeof(buffer) );
+		if (nRead <= 0) {
+			if ( (nRead == -1) && (errno == EINTR) ) {
+				continue;
+			}
+			break;
+		}
+		for (const char *pos = buffer; pos < buffer + nRead; ) {
+			const struct inotify_event *event = reinterpret_cast<const struct inotify_event*>(pos);
+			pos += sizeof(struct inotify_event) + event->len;
+			if (event->mask & IN_Q_OVERFLOW) { // events were lost
+				runModule_();
+				return;
+			}
+			if (event->len == 0) {
+				continue;
+			}
+			if ( (event->wd == localWatch_) && (event->mask & IN_ISDIR) && splitPackageEntry( event->name, strlen(event->name), name, version ) ) {
+				if ( event->mask & (IN_CREATE | IN_MOVED_TO) ) {
+					localVersions_[name] = version;
+				} else {
+					// during an upgrade the new version is added before the old one is removed
+					const auto installed = localVersions_.find(name);
+					if ( ( installed != localVersions_.end() ) && (installed->second == version) ) {
+						localVersions_.erase(installed);
+					}
+				}
+				changed = true;
+			} else if (event->wd == syncWatch_) {
+				const size_t nameLength = strlen(event->name);
+				if ( (nameLength > 3) && (strcmp(event->name + nameLength - 3, ".db") == 0) ) {
+					const size_t repoInd = static_cast<size_t>( std::find( repositories_.begin(), repositories_.end(), string(event->name, nameLength - 3) ) - repositories_.begin() );
+					if ( repoInd < repositories_.size() ) {
+						staleRepositories[repoInd] = 1;
+					}
+				}
+			}
 		}
-	} else { // wait for a real-time signal
-		runModule_();
-		mutex mtx;
-		while (true) {
-			unique_lock<mutex> lk(mtx);
-			signalCondition_->wait(lk);
-			runModule_();
-			lk.unlock();
+	}
+	for (size_t iRepo = 0; iRepo < repositories_.size(); ++iRepo) {
+		if (staleRepositories[iRepo]) {
+			indexRepository_(iRepo);
+			changed = true;
 		}
 	}
+	if (changed) {
+		publishCount_();
+	}
 }
 
-void ModuleDate::runModule_() const {
-	time_t t = time(nullptr);
-	stringstream outTime;
-	outTime << put_time( localtime(&t), dateFormat_.c_str() );
-	mutex mtx;
-	unique_lock<mutex> lk(mtx);
-	*outString_ = outTime.str();
-	outputCondition_->notify_one();
-	lk.unlock();
+// static member
+const size_t MountProbePool::maxWorkers_ = 4;
+
+MountProbePool::SharedState_::SharedState_() : nWorkers_{0}, nIdle_{0}, stop_{false} {
+	eventFD_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
 }
 
-void ModuleBattery::runModule_() const {
-	string batStatus;
-	fstream statusStream;
-	statusStream.open("/sys/class/power_supply/BAT0/status", ios::in);
-	if ( statusStream.is_open() ) { // fail silently
-		getline(statusStream, batStatus);
-	}
-	statusStream.close();
-	string batCapacityStr;
-	fstream capacityStream;
-	capacityStream.open("/sys/class/power_supply/BAT0/capacity", ios::in);
-	if ( capacityStream.is_open() ) { // fail silently
-		getline(capacityStream, batCapacityStr);
-	}
-	capacityStream.close();
-	float batCapacity = 0.0;
-	if ( batCapacityStr.size() ) {
-		batCapacity = stof(batCapacityStr);
-	}
-	mutex mtx;
-	unique_lock<mutex> lk(mtx);
-	if (batStatus == "Charging") {
-		if (batCapacity < 5.0) {
-			*outString_ = batCapacityStr + "% \uf58d";
-		} else if (batCapacity < 20.0) {
-			*outString_ = batCapacityStr + "% \uf585";
-		} else if (batCapacity < 30.0) {
-			*outString_ = batCapacityStr + "% \uf586";
-		} else if (batCapacity < 40.0) {
-			*outString_ = batCapacityStr + "% \uf587";
-		} else if (batCapacity < 60.0) {
-			*outString_ = batCapacityStr + "% \uf588";
-		} else if (batCapacity < 80.0) {
-			*outString_ = batCapacityStr + "% \uf589";
-		} else if (batCapacity < 90.0) {
-			*outString_ = batCapacityStr + "% \uf58a";
-		} else if (batCapacity < 100.0){
-			*outString_ = batCapacityStr + "% \uf578";
+MountProbePool::SharedState_::~SharedState_(){
+	if (eventFD_ != -1) {
+		close(eventFD_);
+	}
+}
+
+MountProbePool::MountProbePool() : state_{new SharedState_} {
+}
+
+MountProbePool::~MountProbePool(){
+	lock_guard<mutex> lock(state_->mtx_);
+	state_->stop_ = true;
+	state_->queue_.clear();
+	state_->requestReady_.notify_all();
+}
+
+void MountProbePool::request(const shared_ptr<MountProbe> &probe){
+	lock_guard<mutex> lock(state_->mtx_);
+	const auto samePoint = [&probe](const shared_ptr<MountProbe> &queued){ return queued->mountPoint_ == probe->mountPoint_; };
+	if ( std::any_of(state_->queue_.begin(), state_->queue_.end(), samePoint) || std::any_of(state_->active_.begin(), state_->active_.end(), samePoint) ) {
+		return;
+	}
+	probe->completed_ = false;
+	state_->queue_.push_back(probe);
+	if ( (state_->nIdle_ < state_->queue_.size()) && (state_->nWorkers_ < maxWorkers_) ) {
+		std::thread(work_, state_).detach();
+		++state_->nWorkers_;
+		++state_->nIdle_; // counted as idle right away, so that a burst of requests does not start a worker for each
+	}
+	state_->requestReady_.notify_one();
+}
+
+void MountProbePool::cancel(const shared_ptr<MountProbe> &probe){
+	lock_guard<mutex> lock(state_->mtx_);
+	const auto queued = std::find(state_->queue_.begin(), state_->queue_.end(), probe);
+	if ( queued != state_->queue_.end() ) {
+		state_->queue_.erase(queued);
+	}
+}
+
+bool MountProbePool::collect(const shared_ptr<MountProbe> &probe, bool &success, uint64_t &available){
+	lock_guard<mutex> lock(state_->mtx_);
+	if (!probe->completed_) {
+		return false;
+	}
+	probe->completed_ = false;
+	success           = probe->success_;
+	if (success) {
+		available = probe->available_;
+	}
+	return true;
+}
+
+void MountProbePool::clearCompletions(){
+	uint64_t nCompleted;
+	while ( (read( state_->eventFD_, &nCompleted, sizeof(nCompleted) ) == -1) && (errno == EINTR) ) {
+	}
+}
+
+void MountProbePool::work_(shared_ptr<SharedState_> state){
+	unique_lock<mutex> lock(state->mtx_);
+	while (true) {
+		state->requestReady_.wait(lock, [&state]{return state->stop_ || !state->queue_.empty();});
+		if (state->stop_) {
+			return;
 		}
-	} else {
-		if (batCapacity < 5.0) {
-			*outString_ = batCapacityStr + "% \uf58d";
-		} else if (batCapacity < 10.0) {
-			*outString_ = batCapacityStr + "% \uf579";
-		} else if (batCapacity < 20.0) {
-			*outString_ = batCapacityStr + "% \uf57a";
-		} else if (batCapacity < 30.0) {
-			*outString_ = batCapacityStr + "% \uf57b";
-		} else if (batCapacity < 40.0) {
-			*outString_ = batCapacityStr + "% \uf57c";
-		} else if (batCapacity < 50.0) {
-			*outString_ = batCapacityStr + "% \uf57d";
-		} else if (batCapacity < 60.0) {
-			*outString_ = batCapacityStr + "% \uf57e";
-		} else if (batCapacity < 70.0) {
-			*outString_ = batCapacityStr + "% \uf57f";
-		} else if (batCapacity < 80.0) {
-			*outString_ = batCapacityStr + "% \uf580";
-		} else if (batCapacity < 90.0) {
-			*outString_ = batCapacityStr + "% \uf581";
-		} else if (batCapacity < 100.0){
-			*outString_ = batCapacityStr + "% \uf578";
-		} else {
-			if (batStatus == "Discharging") {
-				*outString_ = batCapacityStr + "% \uf578";
-			} else {
-				*outString_ = batCapacityStr + "% \uf583";
-			}
+		--state->nIdle_;
+		shared_ptr<MountProbe> probe = state->queue_.front();
+		state->queue_.pop_front();
+		state->active_.push_back(probe);
+		lock.unlock();
+		struct statvfs buf;
+		const bool success = ( statvfs(probe->mountPoint_.c_str(), &buf) == 0 ); // may block for a long time on network file systems
+		lock.lock();
+		probe->success_   = success;
+		probe->available_ = ( success ? static_cast<uint64_t>(buf.f_bavail)*static_cast<uint64_t>(buf.f_bsize) : 0 );
+		probe->completed_ = true;
+		state->active_.erase( std::find(state->active_.begin(), state->active_.end(), probe) );
+		++state->nIdle_;
+		const uint64_t increment = 1;
+		write( state->eventFD_, &increment, sizeof(increment) );
+	}
+}
+
+ModuleDisk::ModuleDisk(const uint32_t &interval, const vector<string> &fsVector, const vector<string> &fsTypes, const milliseconds &timeout, const string &staleMarker, const string &unmountedMarker, const string &readOnlyMarker, OutputSlot *output, RenderTrigger *trigger, const int &sigFD) : Module(interval, output, trigger, sigFD), fsTypes_{fsTypes}, nListed_{fsVector.size()}, timeout_{timeout}, staleMarker_{staleMarker}, unmountedMarker_{unmountedMarker}, readOnlyMarker_{readOnlyMarker}, mountInfoFile_{"/proc/self/mountinfo"}, timerFD_{-1}, measuring_{false} {
+	makeEventFD_();
+	watchDescriptor_(probePool_.fd(), EPOLLIN);
+	timerFD_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	if (timerFD_ != -1) {
+		watchDescriptor_(timerFD_, EPOLLIN);
+	}
+	for (auto &fs : fsVector){
+		addFileSystem_(fs, false);
+	}
+	if ( mountInfoFile_.isOpen() ) {
+		const size_t mountInfoSize = readWholeFile(mountInfoFile_, mountInfoBuffer_);
+		parseMountInfo(mountInfoBuffer_.data(), mountInfoSize, mountPoints_, mountTypes_, mountReadOnly_);
+		// listed paths that are not mount points (e.g., directories on the root file system) cannot be unmounted
+		for (size_t iFS = 0; iFS < nListed_; ++iFS) {
+			tracked_[iFS] = ( std::find(mountPoints_.begin(), mountPoints_.end(), fsNames_[iFS]) != mountPoints_.end() ) ? 1 : 0;
 		}
+		updateMounts_();
+		watchDescriptor_(mountInfoFile_.fd(), EPOLLPRI); // the kernel raises POLLPRI when the mount table changes
+	}
+	outBuffer_.reserve( fsNames_.size()*( 16 + staleMarker_.size() + readOnlyMarker_.size() ) );
+}
 
+ModuleDisk::~ModuleDisk(){
+	if (timerFD_ != -1) {
+		close(timerFD_);
 	}
-	outputCondition_->notify_one();
-	lk.unlock();
 }
 
-void ModuleCPU::runModule_() const{
-	string tempStatus;
-	fstream tempStream;
-	tempStream.open("/sys/class/thermal/thermal_zone0/temp", ios::in);
-	if ( tempStream.is_open() ) {        // fail silently
-		getline(tempStream, tempStatus);
-	}
-	tempStream.close();
-	int32_t cpuTemp = 0;
-	if ( tempStatus.size() ) {
-		cpuTemp = stoi(tempStatus)/1000;
-	}
-	string loadLine;
-	fstream loadFileStream;
-	// the CPU usage data in this file are cumulative, so I must keep the values from the previous iteration (previous*_ private members)
-	// I then subtract these previous values to get the data for the measurement interval
-	loadFileStream.open("/proc/stat", ios::in);
-	if ( loadFileStream.is_open() ) {    // fail silently
-		getline(loadFileStream, loadLine);
-	}
-	loadFileStream.close();
-	float curTotalLoad = 0.0;
-	float curIdleLoad  = 0.0;
-	float percentLoad  = 0.0;
-	if ( loadLine.size() ) {
-		string field;
-		stringstream lineStream(loadLine);
-		lineStream >> field; // first filed is the line name
-		uint16_t fInd = 1;
-		while (lineStream >> field) {
-			if ( (fInd == 4) || (fInd == 5) ) {
-				curIdleLoad  += stod(field);
-				curTotalLoad += stod(field);
-			} else {
-				curTotalLoad += stod(field);
+void ModuleDisk::addFileSystem_(const string &fsName, const bool &tracked) const {
+	fsNames_.push_back(fsName);
+	probes_.push_back( std::make_shared<MountProbe>(fsName) );
+	available_.push_back(0);
+	measured_.push_back(0);
+	fresh_.push_back(0);
+	waiting_.push_back(0);
+	tracked_.push_back(tracked ? 1 : 0);
+	mounted_.push_back(1);
+	readOnly_.push_back(0);
+}
+
+void ModuleDisk::removeFileSystem_(const size_t &fsInd) const {
+	probePool_.cancel(probes_[fsInd]);
+	fsNames_.erase(fsNames_.begin() + fsInd);
+	probes_.erase(probes_.begin() + fsInd);
+	available_.erase(available_.begin() + fsInd);
+	measured_.erase(measured_.begin() + fsInd);
+	fresh_.erase(fresh_.begin() + fsInd);
+	waiting_.erase(waiting_.begin() + fsInd);
+	tracked_.erase(tracked_.begin() + fsInd);
+	mounted_.erase(mounted_.begin() + fsInd);
+	readOnly_.erase(readOnly_.begin() + fsInd);
+}
+
+void ModuleDisk::updateMounts_() const {
+	// file systems selected by type come and go with their mounts; listed file systems stay and are marked when unmounted
+	for (size_t iFS = nListed_; iFS < fsNames_.size(); ) {
+		bool present = false;
+		for (size_t iMount = 0; iMount < mountPoints_.size(); ++iMount) {
+			if ( (mountPoints_[iMount] == fsNames_[iFS]) && ( std::find(fsTypes_.begin(), fsTypes_.end(), mountTypes_[iMount]) != fsTypes_.end() ) ) {
+				present = true;
+				break;
 			}
-			fInd++;
 		}
-		percentLoad        = ( 1.0 - (curIdleLoad - previousIdleLoad_)/(curTotalLoad - previousTotalLoad_) )*100;
-		previousIdleLoad_  = curIdleLoad;
-		previousTotalLoad_ = curTotalLoad;
+		if (present) {
+			++iFS;
+		} else {
+			removeFileSystem_(iFS);
+		}
+	}
+	for (size_t iMount = 0; iMount < mountPoints_.size(); ++iMount) {
+		if ( ( std::find(fsTypes_.begin(), fsTypes_.end(), mountTypes_[iMount]) != fsTypes_.end() ) &&
+				( std::find(fsNames_.begin(), fsNames_.end(), mountPoints_[iMount]) == fsNames_.end() ) ) {
+			addFileSystem_(mountPoints_[iMount], true);
+		}
+	}
+	// the file system holding a path is the last mounted (i.e., top) of the longest mount points that contain it
+	for (size_t iFS = 0; iFS < fsNames_.size(); ++iFS) {
+		const string &fs = fsNames_[iFS];
+		size_t bestLength = 0;
+		size_t bestMount  = mountPoints_.size();
+		for (size_t iMount = 0; iMount < mountPoints_.size(); ++iMount) {
+			const string &mp = mountPoints_[iMount];
+			const bool contains = (fs.compare(0, mp.size(), mp) == 0) && ( (fs.size() == mp.size()) || (mp == "/") || (fs[mp.size()] == '/') );
+			if ( contains && (mp.size() >= bestLength) ) {
+				bestLength = mp.size();
+				bestMount  = iMount;
+			}
+		}
+		const bool mounted = ( bestMount < mountPoints_.size() ) && ( !tracked_[iFS] || (mountPoints_[bestMount] == fs) );
+		if (!mounted) {
+			measured_[iFS] = 0; // the old value belongs to a file system that is gone
+		}
+		mounted_[iFS]  = mounted ? 1 : 0;
+		readOnly_[iFS] = ( mounted && mountReadOnly_[bestMount] ) ? 1 : 0;
 	}
-	string thermGlyph;
-	if (cpuTemp < 35) {
-		thermGlyph = "\ue20c";
-	} else if (cpuTemp < 80) {
-		thermGlyph = "\ue20a";
-	} else {
-		thermGlyph = "\ue20b";
-	}
-	stringstream pctStr;
-	pctStr << fixed << setprecision(1) << percentLoad;
-	const string loadOut = "\ufb19 " + pctStr.str() + "% " + thermGlyph + " " + to_string(cpuTemp) + "°C";
-	mutex mtx;
-	unique_lock<mutex> lk(mtx);
-	*outString_ = loadOut;
-	outputCondition_->notify_one();
-	lk.unlock();
 }
 
-void ModuleRAM::runModule_() const {
-	string memLine;
-	fstream memInfoStream;
-	memInfoStream.open("/proc/meminfo", ios::in);
-	while ( getline(memInfoStream, memLine) ){
-		if (memLine.compare(0, 13, "MemAvailable:") == 0) {
-			break;
+void ModuleDisk::processEvent_(const int &fd, const uint32_t &events) const {
+	if (fd == probePool_.fd()) {
+		probePool_.clearCompletions();
+		collectProbes_();
+		return;
+	}
+	if ( (fd == timerFD_) && (timerFD_ != -1) ) {
+		uint64_t nExpirations;
+		if ( (read( timerFD_, &nExpirations, sizeof(nExpirations) ) == sizeof(nExpirations)) && measuring_ ) {
+			publishSpace_();
 		}
+		return;
 	}
-	memInfoStream.close();
-	stringstream memLineStream(memLine);
-	string freeMemStr;
-	memLineStream >> freeMemStr;
-	memLineStream >> freeMemStr;
-	float memGi = stof(freeMemStr)/1048576.0; // the value in the file is in kb
-	stringstream outMemStr;
-	outMemStr << fixed << setprecision(1) << memGi;
-	mutex mtx;
-	unique_lock<mutex> lk(mtx);
-	*outString_ = "\uf85a " + outMemStr.str() + "Gi";
-	outputCondition_->notify_one();
-	lk.unlock();
+	const size_t mountInfoSize = readWholeFile(mountInfoFile_, mountInfoBuffer_);
+	parseMountInfo(mountInfoBuffer_.data(), mountInfoSize, mountPoints_, mountTypes_, mountReadOnly_);
+	updateMounts_();
+	runModule_();
 }
 
 void ModuleDisk::runModule_() const {
+	// all file systems are measured at the same time, so a file system that hangs delays the output by the timeout at most
+	// unmounted file systems are not measured: statvfs would report the file system underneath
+	bool anyRequested = false;
+	for (size_t iFS = 0; iFS < probes_.size(); ++iFS) {
+		fresh_[iFS]   = 0;
+		waiting_[iFS] = mounted_[iFS];
+		if (mounted_[iFS]) {
+			probePool_.request(probes_[iFS]);
+			anyRequested = true;
+		}
+	}
+	if ( !anyRequested || (timerFD_ == -1) ) {
+		publishSpace_();
+		return;
+	}
+	measuring_ = true;
+	struct itimerspec timeout;
+	timeout.it_interval.tv_sec  = 0;
+	timeout.it_interval.tv_nsec = 0;
+	timeout.it_value.tv_sec     = static_cast<time_t>(timeout_.count()/1000);
+	timeout.it_value.tv_nsec    = std::max(static_cast<long>(timeout_.count()%1000)*1000000L, 1L); // zero would disarm the timer
+	timerfd_settime(timerFD_, 0, &timeout, nullptr);
+}
+
+void ModuleDisk::collectProbes_() const {
+	bool collected = false;
+	bool waiting   = false;
+	for (size_t iFS = 0; iFS < probes_.size(); ++iFS) {
+		bool success = false;
+		if ( probePool_.collect(probes_[iFS], success, available_[iFS]) ) {
+			collected      = true;
+			waiting_[iFS]  = 0;
+			fresh_[iFS]    = ( success && mounted_[iFS] ) ? 1 : 0;
+			measured_[iFS] = measured_[iFS] || fresh_[iFS];
+		}
+		waiting = waiting || waiting_[iFS];
+	}
+	// a file system that responds after the timeout updates the output right away
+	if ( (measuring_ && !waiting) || (!measuring_ && collected) ) {
+		publishSpace_();
+	}
+}
+
+void ModuleDisk::publishSpace_() const {
+	if (measuring_) {
+		measuring_ = false;
+		struct itimerspec disarm;
+		memset( &disarm, 0, sizeof(disarm) );
+		timerfd_settime(timerFD_, 0, &disarm, nullptr);
+	}
 	// start the output with the home icon for the home file system
 	// (assuming that it's in the first element of the file system vector)
-	string output;
-	uint16_t iconInd = 0;
-	for (auto &fs : fsNames_){
-		output += (iconInd == 0 ? "\uf015 " : "  \uf0a0 ");
-		iconInd++;
-		struct statvfs buf;
-		int test = statvfs(fs.c_str(), &buf);
-		float diskSpace = 0.0;
-		if (test == 0) {
-			diskSpace = static_cast<float>(buf.f_bavail * buf.f_bsize)/1073741824.0;
-		}
-		stringstream dsStream;
-		dsStream << fixed << setprecision(0) << diskSpace;
-		output += dsStream.str() + "Gi";
-	}
-	// add RAID information if available
-	fstream raidStream;
-	raidStream.open("/proc/mdstat", ios::in);
-	string mdstatLine;
-	vector<string> mdstatDeviceLines;
-	if ( raidStream.good() ) {
-		while ( getline(raidStream, mdstatLine) ) {
-			if (mdstatLine.compare(0, 2, "md") == 0) { // found the array line
-				string curDevLine;
-				getline(raidStream, curDevLine);
-				mdstatDeviceLines.push_back(curDevLine); // in case there is more than one array on the system
-			}
-		}
-	}
-	if ( raidStream.is_open() ) {
-		raidStream.close();
-	}
-	vector<string> deviceStatus;
-	if ( mdstatDeviceLines.size() ) {
-		for (auto &mdl : mdstatDeviceLines){
-			string curStatus;
-			for (auto &mdc : mdl){
-				if (mdc == 'U') {
-					curStatus += "\uf431";
-				} else if (mdc == '_') {
-					curStatus += "\uf433";
+	outBuffer_.clear();
+	char number[32];
+	for (size_t iFS = 0; iFS < probes_.size(); ++iFS) {
+		outBuffer_ += (iFS == 0 ? "\uf015 " : "  \uf0a0 ");
+		if (!mounted_[iFS]) {
+			outBuffer_ += unmountedMarker_;
+			continue;
+		}
+		if (!measured_[iFS]) {
+			outBuffer_ += '?';
+			continue;
+		}
+		const int length = snprintf( number, sizeof(number), "%lluGi", static_cast<unsigned long long>( (available_[iFS] + 536870912)/1073741824 ) );
+		outBuffer_.append(number, static_cast<size_t>(length));
+		if (readOnly_[iFS]) {
+			outBuffer_ += readOnlyMarker_;
+		}
+		if (!fresh_[iFS]) {
+			outBuffer_ += staleMarker_;
+		}
+	}
+	if ( outBuffer_.size() ) {
+		publish_(outBuffer_);
+	}
+}
+
+ModuleRAID::ModuleRAID(const uint32_t &interval, const uint32_t &progressInterval, OutputSlot *output, RenderTrigger *trigger, const int &sigFD) : Module(interval, output, trigger, sigFD), progressInterval_{progressInterval}, mdstatFile_{"/proc/mdstat"}, timerFD_{-1}, syncing_{false} {
+	mdstatBuffer_.resize(16384);
+	outBuffer_.reserve(64);
+	if ( !mdstatFile_.isOpen() ) { // no md driver; fail silently
+		return;
+	}
+	makeEventFD_();
+	watchDescriptor_(mdstatFile_.fd(), EPOLLPRI); // the file is always readable, so only POLLPRI is meaningful
+	if (progressInterval_) {
+		timerFD_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+		if (timerFD_ != -1) {
+			watchDescriptor_(timerFD_, EPOLLIN);
+		}
+	}
+}
+
+ModuleRAID::~ModuleRAID(){
+	if (timerFD_ != -1) {
+		close(timerFD_);
+	}
+}
+
+void ModuleRAID::processEvent_(const int &fd, const uint32_t &events) const {
+	if (fd == timerFD_) {
+		uint64_t nExpirations;
+		if (read( timerFD_, &nExpirations, sizeof(nExpirations) ) != sizeof(nExpirations)) {
+			return;
+		}
+	}
+	runModule_();
+}
+
+void ModuleRAID::runModule_() const {
+	const size_t mdstatSize = mdstatFile_.read( mdstatBuffer_.data(), mdstatBuffer_.size() );
+	outBuffer_.clear();
+	bool syncing    = false;
+	const char *end = mdstatBuffer_.data() + mdstatSize;
+	const char *pos = mdstatBuffer_.data();
+	char number[32];
+	while (pos < end) {
+		const char *lineEnd = static_cast<const char*>( memchr(pos, '\n', static_cast<size_t>(end - pos)) );
+		if (lineEnd == nullptr) {
+			lineEnd = end;
+		}
+		const size_t lineLength = static_cast<size_t>(lineEnd - pos);
+		// array lines start with the array name; the member status and progress lines that follow are indented
+		// arrays without redundancy (e.g., RAID0) have no member status and are not shown
+		if ( (lineLength > 0) && (pos[0] == ' ') && ( memchr(pos, '[', lineLength) != nullptr ) ) {
+			const char *progress = static_cast<const char*>( memmem(pos, lineLength, "% (", 3) );
+			if (progress != nullptr) {     // e.g., "[=>....]  resync =  8.5% (83713024/976630464) finish=71.2min speed=208887K/sec"
+				const char *percent = progress;
+				while ( (percent > pos) && ( (percent[-1] == '.') || ( (percent[-1] >= '0') && (percent[-1] <= '9') ) ) ) {
+					--percent;
+				}
+				outBuffer_ += ' ';
+				outBuffer_.append(percent, static_cast<size_t>(progress - percent) + 1);
+				const char *speed = static_cast<const char*>( memmem(pos, lineLength, "speed=", 6) );
+				if (speed != nullptr) {
+					uint64_t kibPerSecond;
+					parseUnsigned(speed + 6, lineEnd, kibPerSecond);
+					const int length = ( kibPerSecond < 1024 ? snprintf(number, sizeof(number), " %uK/s", static_cast<unsigned>(kibPerSecond)) :
+						snprintf(number, sizeof(number), " %uM/s", static_cast<unsigned>(kibPerSecond/1024)) );
+					outBuffer_.append(number, static_cast<size_t>(length));
+				}
+				syncing = true;
+			} else if ( memmem(pos, lineLength, "blocks", 6) != nullptr ) {
+				// the member status is the last bracketed field, e.g., "976630464 blocks super 1.2 [2/2] [U_]"
+				const char *status = lineEnd;
+				while ( (status > pos) && (status[-1] != '[') ) {
+					--status;
+				}
+				outBuffer_ += ( outBuffer_.empty() ? "\uf98a " : " " );
+				for (; (status < lineEnd) && (*status != ']'); ++status) {
+					if (*status == 'U') {
+						outBuffer_ += "\uf431";
+					} else if (*status == '_') {
+						outBuffer_ += "\uf433";
+					}
 				}
 			}
-			deviceStatus.push_back(curStatus);
 		}
-		output += "  \uf98a";
-		for (auto &ds : deviceStatus){
-			output += " " + ds;
+		pos = lineEnd + 1;
+	}
+	if ( (timerFD_ != -1) && (syncing != syncing_) ) { // poll for progress only while an operation runs
+		struct itimerspec period;
+		period.it_interval.tv_sec  = (syncing ? progressInterval_ : 0);
+		period.it_interval.tv_nsec = 0;
+		period.it_value            = period.it_interval;
+		timerfd_settime(timerFD_, 0, &period, nullptr);
+	}
+	syncing_ = syncing;
+	publish_(outBuffer_);
+}
+
+// static members
+const string ExternalCommand::shellCharacters_ = "|&;<>()$`\\\"'*?[]{}#~=%!\n";
+const milliseconds ExternalCommand::terminateGrace_(1000);
+
+ExternalCommand::ExternalCommand(const string &command){
+	const char *home = getenv("HOME");
+	stringstream commandStream(command);
+	string word;
+	bool needShell = false;
+	while (commandStream >> word) {
+		if ( (home != nullptr) && (word.compare(0, 2, "~/") == 0) ) {
+			word.replace(0, 1, home);
+		}
+		if (word.find_first_of(shellCharacters_) != string::npos) {
+			needShell = true;
+			break;
 		}
+		arguments_.push_back(word);
 	}
-	mutex mtx;
-	unique_lock<mutex> lk(mtx);
-	if ( output.size() ) {
-		*outString_ = output;
+	if ( needShell || arguments_.empty() ) {
+		arguments_ = {"/bin/sh", "-c", command};
 	}
-	outputCondition_->notify_one();
-	lk.unlock();
+	for (auto &arg : arguments_){
+		argv_.push_back( &arg[0] );
+	}
+	argv_.push_back(nullptr);
 }
 
-// static member
-const size_t ModuleExtern::lengthLimit_ = 500;
+pid_t ExternalCommand::spawn(int &readFD) const {
+	int pipeFDs[2];
+	if (pipe2(pipeFDs, O_CLOEXEC) == -1) {
+		return -1;
+	}
+	fcntl(pipeFDs[0], F_SETFL, O_NONBLOCK);  // only the read end; the command's standard output stays blocking
+	posix_spawn_file_actions_t fileActions;
+	posix_spawn_file_actions_init(&fileActions);
+	posix_spawn_file_actions_adddup2(&fileActions, pipeFDs[1], STDOUT_FILENO); // dup2() clears close-on-exec on the copy
+	// real-time signals are blocked in dwmbar threads; the command should start with an empty signal mask
+	sigset_t emptyMask;
+	sigemptyset(&emptyMask);
+	posix_spawnattr_t attributes;
+	posix_spawnattr_init(&attributes);
+	posix_spawnattr_setsigmask(&attributes, &emptyMask);
+	// a separate process group lets a timed out command be terminated together with its children
+	posix_spawnattr_setpgroup(&attributes, 0);
+	posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETPGROUP);
+	pid_t pid = -1;
+	if (posix_spawnp(&pid, argv_[0], &fileActions, &attributes, argv_.data(), environ) != 0) {
+		pid = -1;
+	}
+	posix_spawnattr_destroy(&attributes);
+	posix_spawn_file_actions_destroy(&fileActions);
+	close(pipeFDs[1]);
+	if (pid == -1) {
+		close(pipeFDs[0]);
+		return -1;
+	}
+	readFD = pipeFDs[0];
+	return pid;
+}
+
+bool ExternalCommand::reap(const pid_t &pid){
+	pid_t waitRes;
+	while ( ( ( waitRes = waitpid(pid, nullptr, WNOHANG) ) == -1 ) && (errno == EINTR) ) {
+	}
+	return (waitRes == pid) || ( (waitRes == -1) && (errno == ECHILD) );
+}
+
+bool ExternalCommand::waitForExit(const pid_t &pid, const steady_clock::time_point &deadline){
+	milliseconds pause(1);
+	while (true) {
+		if ( reap(pid) ) {
+			return true;
+		}
+		const steady_clock::time_point now = steady_clock::now();
+		if (now >= deadline) {
+			return false;
+		}
+		sleep_for( std::min( pause, std::chrono::duration_cast<milliseconds>(deadline - now) + milliseconds(1) ) );
+		pause = std::min(pause*2, milliseconds(50));
+	}
+}
+
+void ExternalCommand::terminate(const pid_t &pid){
+	kill(-pid, SIGTERM);
+	if ( waitForExit(pid, steady_clock::now() + terminateGrace_) ) {
+		return;
+	}
+	kill(-pid, SIGKILL);
+	while ( (waitpid(pid, nullptr, 0) == -1) && (errno == EINTR) ) {
+	}
+}
+
+StreamingCommand::StreamingCommand(const string &command, const size_t &lengthLimit) : extCommand_{command}, lengthLimit_{lengthLimit}, pid_{-1}, readFD_{-1}, stoppedPid_{-1} {
+	lineBuffer_.reserve(2*lengthLimit_);
+}
+
+StreamingCommand::~StreamingCommand(){
+	if (readFD_ != -1) {
+		close(readFD_);
+	}
+	if (pid_ != -1) {
+		ExternalCommand::terminate(pid_);
+	}
+	if (stoppedPid_ != -1) {
+		ExternalCommand::terminate(stoppedPid_);
+	}
+}
+
+bool StreamingCommand::start(){
+	if (pid_ != -1) {
+		return false;
+	}
+	reapStopped_();
+	if (stoppedPid_ != -1) { // the previous command is still exiting; try again later
+		return false;
+	}
+	pid_ = extCommand_.spawn(readFD_);
+	return pid_ != -1;
+}
+
+void StreamingCommand::stop(){
+	if (readFD_ != -1) {
+		close(readFD_);
+		readFD_ = -1;
+	}
+	if (pid_ != -1) {
+		kill(-pid_, SIGTERM);
+		if ( !ExternalCommand::reap(pid_) ) { // reaped at the next start
+			stoppedPid_ = pid_;
+		}
+		pid_ = -1;
+	}
+	lineBuffer_.clear();
+}
+
+bool StreamingCommand::readLine(string &line, bool &finished){
+	finished = false;
+	if (readFD_ == -1) {
+		return false;
+	}
+	return readLastLine(readFD_, lengthLimit_, lineBuffer_, line, finished);
+}
+
+void StreamingCommand::reapStopped_(){
+	if (stoppedPid_ == -1) {
+		return;
+	}
+	if ( !ExternalCommand::reap(stoppedPid_) ) {
+		// at least a refresh interval has passed since SIGTERM
+		kill(-stoppedPid_, SIGKILL);
+		if ( !ExternalCommand::reap(stoppedPid_) ) {
+			return;
+		}
+	}
+	stoppedPid_ = -1;
+}
+
+// static members
+const size_t ModuleExtern::lengthLimit_          = 500;
+const milliseconds ModuleExtern::maxPollInterval_(50);
+
+ModuleExtern::ModuleExtern(const uint32_t &interval, const string &command, const uint32_t &timeout, const string &timeoutMarker, OutputSlot *output, RenderTrigger *trigger, const int &sigFD) : Module(interval, output, trigger, sigFD), extCommand_{command}, timeout_{timeout}, timeoutMarker_{timeoutMarker}, timerFD_{-1}, stage_{Stage::idle}, pid_{-1}, readFD_{-1}, outSize_{0}, pollInterval_{1} {
+	outBuffer_.resize(lengthLimit_);
+	makeEventFD_();
+	timerFD_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	if (timerFD_ != -1) {
+		watchDescriptor_(timerFD_, EPOLLIN);
+	}
+}
+
+ModuleExtern::~ModuleExtern(){
+	closePipe_();
+	if (pid_ != -1) {
+		ExternalCommand::terminate(pid_);
+	}
+	if (timerFD_ != -1) {
+		close(timerFD_);
+	}
+}
+
+void ModuleExtern::closePipe_() const {
+	if (readFD_ != -1) {
+		unwatchDescriptor_(readFD_);
+		close(readFD_);
+		readFD_ = -1;
+	}
+}
+
+void ModuleExtern::armTimer_(const nanoseconds &delay) const {
+	struct itimerspec period;
+	period.it_interval.tv_sec  = 0;
+	period.it_interval.tv_nsec = 0;
+	const int64_t delayNanoseconds = ( delay.count() == 0 ? 0 : std::max( static_cast<int64_t>( delay.count() ), static_cast<int64_t>(1) ) );
+	period.it_value.tv_sec     = static_cast<time_t>(delayNanoseconds/1000000000);
+	period.it_value.tv_nsec    = static_cast<long>(delayNanoseconds%1000000000);
+	timerfd_settime(timerFD_, 0, &period, nullptr);
+}
 
 void ModuleExtern::runModule_() const {
-	char buffer[100];
-	string output;
-	FILE *pipe = popen(extCommand_.c_str(), "r");
-	if (!pipe) { // fail silently
+	if (stage_ != Stage::idle) { // the previous run is still going
+		return;
+	}
+	pid_ = extCommand_.spawn(readFD_);
+	if (pid_ == -1) { // fail silently
 		return;
 	}
-	while ( !feof(pipe) ) {
-		if (fgets(buffer, 100, pipe) != NULL) {
-			output += buffer;
+	watchDescriptor_(readFD_, EPOLLIN);
+	outBuffer_.resize(lengthLimit_);  // never exceeds the capacity, so no allocation
+	outSize_ = 0;
+	stage_   = Stage::reading;
+	if (timeout_) {
+		stageEnd_ = steady_clock::now() + seconds(timeout_);
+		armTimer_( seconds(timeout_) );
+	} else {
+		stageEnd_ = steady_clock::time_point::max();
+	}
+}
+
+void ModuleExtern::processEvent_(const int &fd, const uint32_t &events) const {
+	if ( (fd == readFD_) && (readFD_ != -1) ) {
+		readOutput_();
+	} else if ( (fd == timerFD_) && (timerFD_ != -1) ) {
+		uint64_t nExpirations;
+		if (read( timerFD_, &nExpirations, sizeof(nExpirations) ) != sizeof(nExpirations)) {
+			return;
 		}
-		if (output.size() > lengthLimit_) {
-			output.erase( output.begin()+lengthLimit_, output.end() );
-			break;
+		if (stage_ == Stage::reading) { // the deadline passed before the command closed its output
+			timeOut_();
+		} else if (stage_ != Stage::idle) {
+			checkProcess_();
 		}
 	}
-	pclose(pipe);
-	mutex mtx;
-	unique_lock<mutex> lk(mtx);
-	*outString_ = output;
-	outputCondition_->notify_one();
-	lk.unlock();
+}
+
+void ModuleExtern::readOutput_() const {
+	char discard[512];
+	while (true) {
+		const ssize_t nRead = ( outSize_ < lengthLimit_ ? read(readFD_, &outBuffer_[outSize_], lengthLimit_ - outSize_) : read( readFD_, discard, sizeof(discard) ) );
+		if (nRead > 0) {
+			outSize_ = std::min(outSize_ + static_cast<size_t>(nRead), lengthLimit_);
+			continue;
+		}
+		if ( (nRead == -1) && (errno == EINTR) ) {
+			continue;
+		}
+		if ( (nRead == -1) && (errno == EAGAIN) ) {
+			return;
+		}
+		break; // end of output or a read error
+	}
+	closePipe_();
+	stage_        = Stage::exiting;
+	pollInterval_ = milliseconds(1);
+	checkProcess_();
+}
+
+void ModuleExtern::checkProcess_() const {
+	if ( ExternalCommand::reap(pid_) ) {
+		pid_ = -1;
+		armTimer_( nanoseconds(0) );
+		if (stage_ == Stage::exiting) {
+			outBuffer_.resize(outSize_);
+			lastOutput_ = outBuffer_;
+			publish_(outBuffer_);
+		}
+		stage_ = Stage::idle;
+		return;
+	}
+	const steady_clock::time_point now = steady_clock::now();
+	if (now >= stageEnd_) {
+		if (stage_ == Stage::exiting) {
+			timeOut_();
+			return;
+		}
+		if (stage_ == Stage::terminating) {
+			kill(-pid_, SIGKILL);
+			stage_    = Stage::killed;
+			stageEnd_ = steady_clock::time_point::max();
+		}
+	}
+	// the command normally exits right after closing its output, so check often at first and then back off
+	armTimer_( std::min<nanoseconds>(pollInterval_, stageEnd_ - now) );
+	pollInterval_ = std::min(pollInterval_*2, maxPollInterval_);
+}
+
+void ModuleExtern::timeOut_() const {
+	closePipe_();
+	kill(-pid_, SIGTERM);
+	stage_        = Stage::terminating;
+	stageEnd_     = steady_clock::now() + ExternalCommand::terminateGrace_;
+	pollInterval_ = milliseconds(1);
+	armTimer_(pollInterval_);
+	outBuffer_  = lastOutput_;
+	outBuffer_ += timeoutMarker_;
+	publish_(outBuffer_);
+}
+
+// static member
+const size_t ModuleStream::lengthLimit_ = 500;
+
+ModuleStream::ModuleStream(const uint32_t &interval, const string &command, OutputSlot *output, RenderTrigger *trigger, const int &sigFD) : Module(interval, output, trigger, sigFD), command_(command, lengthLimit_) {
+	makeEventFD_();
+	outBuffer_.reserve(lengthLimit_);
+}
+
+ModuleStream::~ModuleStream(){
+	stop_();
+}
+
+void ModuleStream::stop_() const {
+	if ( command_.isRunning() ) {
+		unwatchDescriptor_( command_.fd() );
+		command_.stop();
+	}
+}
+
+void ModuleStream::runModule_() const {
+	if ( command_.start() ) { // fail silently; try again at the next refresh
+		watchDescriptor_(command_.fd(), EPOLLIN);
+	}
+}
+
+void ModuleStream::processEvent_(const int &fd, const uint32_t &events) const {
+	if ( !command_.isRunning() || (fd != command_.fd()) ) {
+		return;
+	}
+	bool finished = false;
+	if ( command_.readLine(outBuffer_, finished) ) {
+		publish_(outBuffer_);
+	}
+	if (finished) {
+		stop_();
+	}
+}
+
+// static members
+const size_t ModuleGPU::lengthLimit_ = 500;
+
+ModuleGPU::ModuleGPU(const uint32_t &interval, const string &drmRoot, const string &card, const string &command, const uint32_t &hysteresis,
+		OutputSlot *output, RenderTrigger *trigger, const int &sigFD) : Module(interval, output, trigger, sigFD), cardPath_{findDRMCard(drmRoot, card)}, frequencyDivisor_{1},
+		sensors_( (cardPath_.empty() ? string() : cardPath_ + "device/hwmon"), vector<string>(), "first" ), hysteresis_{hysteresis}, command_(command, lengthLimit_), thermalLevel_{0} {
+	outBuffer_.reserve(64);
+	if ( cardPath_.empty() ) {
+		if ( !command.empty() ) { // the event descriptor also marks that there is a fallback command to run
+			makeEventFD_();
+		}
+		return;
+	}
+	busyFile_      = PersistentFile(cardPath_ + "device/gpu_busy_percent");
+	frequencyFile_ = PersistentFile(cardPath_ + "gt_act_freq_mhz");
+	if ( !frequencyFile_.isOpen() ) { // amdgpu reports the shader clock in Hz through hwmon
+		const string hwmonPath = cardPath_ + "device/hwmon/";
+		DIR *hwmonDir = opendir( hwmonPath.c_str() );
+		if (hwmonDir != nullptr) {
+			struct dirent *entry;
+			while ( ( entry = readdir(hwmonDir) ) != nullptr ) {
+				if (entry->d_name[0] != '.') {
+					frequencyFile_    = PersistentFile(hwmonPath + entry->d_name + "/freq1_input");
+					frequencyDivisor_ = 1000000;
+					break;
+				}
+			}
+			closedir(hwmonDir);
+		}
+	}
+}
+
+ModuleGPU::~ModuleGPU(){
+	stop_();
+}
+
+void ModuleGPU::stop_() const {
+	if ( command_.isRunning() ) {
+		unwatchDescriptor_( command_.fd() );
+		command_.stop();
+	}
+}
+
+void ModuleGPU::publishValues_(const int64_t &busy, const int64_t &temperature, const bool &haveTemperature, const uint64_t &frequency) const {
+	char buffer[96];
+	int length = snprintf(buffer, sizeof(buffer), "\uf008");
+	if (busy >= 0) {
+		length += snprintf(buffer + length, sizeof(buffer) - length, " %d%%", static_cast<int>(busy));
+	}
+	if (haveTemperature) {
+		updateThermalLevel(temperature, hysteresis_, thermalLevel_);
+		length += snprintf(buffer + length, sizeof(buffer) - length, " %s %d°C", thermalGlyphs[thermalLevel_], static_cast<int>(temperature));
+	}
+	if (frequency > 0) {
+		length += snprintf(buffer + length, sizeof(buffer) - length, " %uMHz", static_cast<unsigned>(frequency));
+	}
+	outBuffer_.assign( buffer, static_cast<size_t>(length) );
+	publish_(outBuffer_);
+}
+
+void ModuleGPU::runModule_() const {
+	if ( cardPath_.empty() ) {
+		if ( (eventFD_ != -1) && command_.start() ) { // fail silently; try again at the next refresh
+			watchDescriptor_(command_.fd(), EPOLLIN);
+		}
+		return;
+	}
+	int64_t busy = -1;
+	char buffer[32];
+	const size_t busySize = busyFile_.read( buffer, sizeof(buffer) );
+	if (busySize > 0) {
+		uint64_t value = 0;
+		parseUnsigned(buffer, buffer + busySize, value);
+		busy = static_cast<int64_t>(value);
+	}
+	int64_t temperature        = 0;
+	const bool haveTemperature = sensors_.read(temperature);
+	publishValues_( busy, temperature/1000, haveTemperature, readUnsigned(frequencyFile_)/frequencyDivisor_ );
+}
+
+void ModuleGPU::processEvent_(const int &fd, const uint32_t &events) const {
+	if ( !command_.isRunning() || (fd != command_.fd()) ) {
+		return;
+	}
+	bool finished = false;
+	if ( command_.readLine(line_, finished) ) {
+		// load, temperature, and frequency separated by commas; fields without digits (e.g., [N/A]) are unknown
+		int64_t values[3]      = {-1, -1, -1};
+		const char *fieldStart = line_.data();
+		const char *lineEnd    = fieldStart + line_.size();
+		for (size_t iField = 0; (iField < 3) && (fieldStart <= lineEnd); ++iField) {
+			const char *fieldEnd = static_cast<const char*>( memchr( fieldStart, ',', static_cast<size_t>(lineEnd - fieldStart) ) );
+			if (fieldEnd == nullptr) {
+				fieldEnd = lineEnd;
+			}
+			if (std::find_if( fieldStart, fieldEnd, [](const char &c){ return (c >= '0') && (c <= '9'); } ) != fieldEnd) {
+				uint64_t value = 0;
+				parseUnsigned(fieldStart, fieldEnd, value);
+				values[iField] = static_cast<int64_t>(value);
+			}
+			fieldStart = fieldEnd + 1;
+		}
+		publishValues_( values[0], values[1], (values[1] >= 0), (values[2] > 0 ? static_cast<uint64_t>(values[2]) : 0) );
+	}
+	if (finished) {
+		stop_();
+	}
 }
@@ -30,62 +30,298 @@
 #define modules_hpp
 
 #include <cstddef>
+#include <ctime>
+#include <sys/types.h>
 #include <vector>
 #include <string>
 #include <mutex>
+#include <atomic>
 #include <condition_variable>
+#include <chrono>
+#include <memory>
+#include <deque>
+#include <unordered_map>
 
 using std::vector;
 using std::string;
 using std::condition_variable;
 using std::mutex;
+using std::atomic;
+using std::shared_ptr;
+using std::deque;
+using std::unordered_map;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+using std::chrono::nanoseconds;
 
 namespace DWMBspace {
 
+	/** \brief Module output slot
+	 *
+	 * Passes module output from one writer thread to one reader thread without locking.
+	 * This is a triple buffer: the writer fills a back buffer and atomically swaps it with the middle one,
+	 * and the reader swaps its front buffer with the middle one when new output is available.
+	 * The writer and the reader therefore never touch the same `string`.
+	 */
+	class OutputSlot {
+	public:
+		/** \brief Default constructor */
+		OutputSlot() : back_{0}, middle_{1}, front_{2} {};
+		/** \brief Copy constructor (deleted) */
+		OutputSlot(const OutputSlot &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		OutputSlot& operator=(const OutputSlot &in) = delete;
+		/** \brief Destructor */
+		~OutputSlot() {};
+		/** \brief Write output
+		 *
+		 * Publishes new output if it differs from the previously written one. Must only be called by the writer.
+		 *
+		 * \param[in] output new output
+		 * \return `true` if the output changed
+		 */
+		bool write(const string &output);
+		/** \brief Read output
+		 *
+		 * Returns the latest published output. Must only be called by the reader.
+		 * The reference stays valid until the next call.
+		 *
+		 * \return latest output
+		 */
+		const string& read();
+	private:
+		/** \brief Output buffers */
+		string buffers_[3];
+		/** \brief Last written output
+		 *
+		 * Writer-side copy used for change detection.
+		 */
+		string lastWritten_;
+		/** \brief Index of the writer's buffer */
+		uint8_t back_;
+		/** \brief Index of the shared buffer
+		 *
+		 * The `freshBit_` is set if the buffer holds output the reader has not seen yet.
+		 */
+		atomic<uint8_t> middle_;
+		/** \brief Index of the reader's buffer */
+		uint8_t front_;
+		/** \brief New output flag */
+		static const uint8_t freshBit_;
+		/** \brief Mask to extract the buffer index */
+		static const uint8_t indexMask_;
+	};
+
+	/** \brief Persistent file
+	 *
+	 * Keeps a file descriptor to a `procfs` or `sysfs` file open, so that the file can be re-read without opening it again.
+	 * These files regenerate their contents on every read from the beginning.
+	 */
+	class PersistentFile {
+	public:
+		/** \brief Default constructor */
+		PersistentFile() : fd_{-1} {};
+		/** \brief Constructor
+		 *
+		 * Opens the file. Failure to open is silent; reads then return no data.
+		 *
+		 * \param[in] path file path
+		 */
+		PersistentFile(const string &path);
+		/** \brief Copy constructor (deleted) */
+		PersistentFile(const PersistentFile &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		PersistentFile& operator=(const PersistentFile &in) = delete;
+		/** \brief Move constructor
+		 *
+		 * \param[in] in object to move
+		 */
+		PersistentFile(PersistentFile &&in) : fd_{in.fd_} { in.fd_ = -1; };
+		/** \brief Move assignment
+		 *
+		 * \param[in] in object to move
+		 * \return `PersistentFile` object
+		 */
+		PersistentFile& operator=(PersistentFile &&in);
+		/** \brief Destructor */
+		~PersistentFile();
+		/** \brief Is the file open?
+		 *
+		 * \return `true` if the file is open
+		 */
+		bool isOpen() const { return fd_ != -1; };
+		/** \brief File descriptor
+		 *
+		 * \return file descriptor, -1 if the file is not open
+		 */
+		int fd() const { return fd_; };
+		/** \brief Read the file
+		 *
+		 * Reads from the start of the file with `pread` and null-terminates the data.
+		 *
+		 * \param[out] buffer buffer for the file contents
+		 * \param[in] size buffer size (including the terminating null)
+		 * \return number of bytes read, excluding the terminating null
+		 */
+		size_t read(char *buffer, const size_t &size) const;
+	private:
+		/** \brief File descriptor */
+		int fd_;
+	};
+
+	/** \brief Render trigger
+	 *
+	 * Lets modules tell the main thread that the bar needs to be re-drawn.
+	 * Notifications that arrive while the main thread is busy are not lost, and bursts of notifications can be merged into one render.
+	 */
+	class RenderTrigger {
+	public:
+		/** \brief Default constructor */
+		RenderTrigger() : pending_{false}, nNotifications_{0} {};
+		/** \brief Copy constructor (deleted) */
+		RenderTrigger(const RenderTrigger &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		RenderTrigger& operator=(const RenderTrigger &in) = delete;
+		/** \brief Destructor */
+		~RenderTrigger() {};
+		/** \brief Request a render */
+		void notify();
+		/** \brief Wait for render requests
+		 *
+		 * Blocks until at least one render has been requested. Then waits for the coalescing window so that requests arriving during it are served by the same render.
+		 *
+		 * \param[in] window coalescing window
+		 * \return number of requests served by this render
+		 */
+		uint64_t wait(const milliseconds &window);
+	private:
+		/** \brief Mutex protecting the state */
+		mutex mtx_;
+		/** \brief Condition variable the main thread waits on */
+		condition_variable condition_;
+		/** \brief A render has been requested */
+		bool pending_;
+		/** \brief Number of requests since the last render */
+		uint64_t nNotifications_;
+	};
+
 	/** \brief Base module class
 	 *
 	 * Establishes the common parameters for all modules. Modules are functors that write output to a `string` variable.
+	 * Event-driven modules also watch file descriptors through their own `epoll` instance (`eventFD_`).
+	 * The module thread or the event loop waits on that single descriptor and calls `handleEvents_()` when it becomes readable.
 	 *
 	 */
 	class Module {
+		friend class EventLoop;
 	public:
 		/** \brief Destructor */
-		virtual ~Module(){ outString_ = nullptr; outputCondition_ = nullptr; };
+		virtual ~Module();
 		/** Run the module
 		 *
 		 * Runs the module, refreshing at the specified interval or after receiving a refresh signal.
 		 */
 		void operator()() const;
+		/** \brief Align refreshes to the wall clock
+		 *
+		 * If set, the module refreshes at multiples of its interval in local time (e.g., at the top of every minute for a 60 second interval)
+		 * instead of at multiples of the interval from the program start.
+		 *
+		 * \param[in] align alignment switch
+		 */
+		void alignToClock(const bool &align){ alignToClock_ = align; };
 	protected:
 		/** Default constructor */
-		Module() : refreshInterval_{0}, outString_{nullptr}, outputCondition_{nullptr}, signalCondition_{nullptr} {};
+		Module() : refreshInterval_{0}, alignToClock_{false}, outSlot_{nullptr}, outputTrigger_{nullptr}, signalFD_{-1}, eventFD_{-1} {};
 		/** Constructor
 		 *
 		 * \param[in] interval refresh time interval in seconds
-		 * \param[in,out] output pointer to the output storing string
-		 * \param[in,out] cVar pointer to the condition variable for change signaling
-		 * \param[in,out] sigVar pointer to the condition variable to monitor real-time signals
+		 * \param[in,out] output pointer to the output slot
+		 * \param[in,out] trigger pointer to the render trigger for change signaling
+		 * \param[in] sigFD file descriptor that becomes readable when the real-time signal for the module arrives
 		 */
-		Module(const uint32_t &interval, string *output, condition_variable *cVar, condition_variable *sigVar) : refreshInterval_{interval}, outString_{output}, outputCondition_{cVar}, signalCondition_{sigVar} {};
+		Module(const uint32_t &interval, OutputSlot *output, RenderTrigger *trigger, const int &sigFD) : refreshInterval_{interval}, alignToClock_{false}, outSlot_{output}, outputTrigger_{trigger}, signalFD_{sigFD}, eventFD_{-1} {};
 		/** Refresh interval in seconds */
 		uint32_t refreshInterval_;
-		/** Pointer to the `string` that receives output */
-		string *outString_;
-		/** \brief Pointer to a condition variable to signal change in state
+		/** Align refreshes to the wall clock */
+		bool alignToClock_;
+		/** Pointer to the slot that receives output */
+		OutputSlot *outSlot_;
+		/** \brief Pointer to a render trigger to signal change in state
 		 *
 		 * The module is using this to communicate to the main thread.
 		 */
-		condition_variable *outputCondition_;
-		/** \brief Pointer to a condition variable to accept signal events
+		RenderTrigger *outputTrigger_;
+		/** \brief Real-time signal file descriptor
+		 *
+		 * An `eventfd` that becomes readable when the real-time signal assigned to the module arrives. The module thread polls it while waiting for the next refresh.
+		 */
+		int signalFD_;
+		/** \brief Watched descriptor `epoll` instance
 		 *
-		 * The module is waiting for this if it relies on a real-time signal to refresh.
+		 * Readable when any of the descriptors the module watches has an event; -1 if the module is not event-driven.
+		 * Must be created in the constructor, because the event loop registers it at start.
 		 */
-		condition_variable *signalCondition_;
+		int eventFD_;
 		/** \brief Run the module once
 		 *
 		 * Retrieves the data specific to the module and formats the output.
 		 */
 		virtual void runModule_() const = 0;
+		/** \brief Publish module output
+		 *
+		 * Stores the output and alerts the main thread, but only if the output differs from the currently stored one.
+		 *
+		 * \param[in] output new module output
+		 */
+		void publish_(const string &output) const;
+		/** \brief Next wall clock refresh time
+		 *
+		 * Finds the first multiple of the refresh interval in local time that is after the provided time.
+		 *
+		 * \param[in] now current time (seconds since the epoch)
+		 * \return next aligned refresh time (seconds since the epoch)
+		 */
+		time_t nextAlignedTime_(const time_t &now) const;
+		/** \brief Wait for the real-time signal
+		 *
+		 * Waits until the real-time signal for the module arrives or the timeout expires.
+		 *
+		 * \param[in] timeout timeout in milliseconds; negative values mean no timeout
+		 * \return `true` if the signal arrived
+		 */
+		bool waitForSignal_(const int &timeout) const;
+		/** \brief Make the module event-driven
+		 *
+		 * Creates the `epoll` instance for watched descriptors.
+		 */
+		void makeEventFD_();
+		/** \brief Watch a file descriptor
+		 *
+		 * \param[in] fd file descriptor
+		 * \param[in] events `epoll` events to watch for
+		 */
+		void watchDescriptor_(const int &fd, const uint32_t &events) const;
+		/** \brief Stop watching a file descriptor
+		 *
+		 * Must be called before the descriptor is closed.
+		 *
+		 * \param[in] fd file descriptor
+		 */
+		void unwatchDescriptor_(const int &fd) const;
+		/** \brief Handle watched descriptor events
+		 *
+		 * Calls `processEvent_()` for every watched descriptor that is ready. Does not block.
+		 * Some files (e.g., `/proc/self/mountinfo`) clear their readiness when it is checked, so the check that woke the module can consume the event.
+		 * `processEvent_()` is then called once with a file descriptor of -1.
+		 */
+		void handleEvents_() const;
+		/** \brief Process an event on a watched descriptor
+		 *
+		 * \param[in] fd file descriptor (-1 if the module woke up, but no descriptor is ready any more)
+		 * \param[in] events `epoll` events that occurred
+		 */
+		virtual void processEvent_(const int &fd, const uint32_t &events) const {};
 	};
 
 	/** \brief Time and date */
@@ -96,11 +332,11 @@ namespace DWMBspace {
 		/** Constructor
 		 *
 		 * \param[in] interval refresh time interval in seconds
-		 * \param[in,out] output pointer to the output storing string
-		 * \param[in,out] cVar pointer to the condition variable for change signaling
-		 * \param[in,out] sigVar pointer to the condition variable to monitor real-time signals
+		 * \param[in,out] output pointer to the output slot
+		 * \param[in,out] trigger pointer to the render trigger for change signaling
+		 * \param[in] sigFD file descriptor that becomes readable when the real-time signal for the module arrives
 		 */
-		ModuleDate(const uint32_t &interval, const string &dateFormat, string *output, condition_variable *cVar, condition_variable *sigVar) : Module(interval, output, cVar, sigVar), dateFormat_{dateFormat} {};
+		ModuleDate(const uint32_t &interval, const string &dateFormat, OutputSlot *output, RenderTrigger *trigger, const int &sigFD) : Module(interval, output, trigger, sigFD), dateFormat_{dateFormat} {};
 
 		/** \brief Destructor */
 		~ModuleDate() {};
@@ -120,143 +356,1256 @@ namespace DWMBspace {
 
 	/** \brief Battery state
 	 *
-	 * Displays the battery state.
+	 * Displays the aggregate state of all batteries and UPS devices.
+	 * Devices are discovered in the `power_supply` class directory when the module is constructed. Battery-powered peripherals (e.g., wireless mice) are ignored.
+	 * The display shows the combined charge and, when the batteries are charging or discharging, the estimated time to full or empty.
+	 * The module listens to kernel `power_supply` uevents and refreshes when the kernel reports a change (e.g., the AC adapter is plugged in).
+	 * The refresh interval only serves as a fallback, so it can be long.
 	 */
 	class ModuleBattery final : public Module {
 	public:
+		/** \brief Glyph table
+		 *
+		 * Rows are for a discharging, idle (on external power, but not charging), and charging battery.
+		 * Columns are 5% steps of charge, from less than 5% to full.
+		 */
+		typedef const char *const GlyphTable[3][21];
 		/** \brief Default constructor */
-		ModuleBattery() : Module() {};
+		ModuleBattery() : Module(), glyphs_{nullptr}, ueventFD_{-1} {};
 		/** Constructor
 		 *
 		 * \param[in] interval refresh time interval in seconds
-		 * \param[in,out] output pointer to the output storing string
-		 * \param[in,out] cVar pointer to the condition variable for change signaling
-		 * \param[in,out] sigVar pointer to the condition variable to monitor real-time signals
+		 * \param[in] powerSupplyRoot `power_supply` class directory (normally `/sys/class/power_supply`)
+		 * \param[in] glyphs battery glyph table
+		 * \param[in,out] output pointer to the output slot
+		 * \param[in,out] trigger pointer to the render trigger for change signaling
+		 * \param[in] sigFD file descriptor that becomes readable when the real-time signal for the module arrives
 		 */
-		ModuleBattery(const uint32_t &interval, string *output, condition_variable *cVar, condition_variable *sigVar) : Module(interval, output, cVar, sigVar) {};
+		ModuleBattery(const uint32_t &interval, const string &powerSupplyRoot, const GlyphTable &glyphs, OutputSlot *output, RenderTrigger *trigger, const int &sigFD);
+		/** \brief Copy constructor (deleted) */
+		ModuleBattery(const ModuleBattery &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		ModuleBattery& operator=(const ModuleBattery &in) = delete;
 		/** \brief Destructor */
-		~ModuleBattery() {};
+		~ModuleBattery();
 	protected:
+		/** \brief Battery glyph table */
+		const GlyphTable *glyphs_;
+		/** \brief Kernel uevent socket */
+		int ueventFD_;
+		/** \brief Status file (`status`) for each device */
+		vector<PersistentFile> statusFiles_;
+		/** \brief Current charge file for each device
+		 *
+		 * `energy_now` or `charge_now`, or `capacity` for devices that report neither.
+		 */
+		vector<PersistentFile> nowFiles_;
+		/** \brief Full charge file (`energy_full` or `charge_full`) for each device */
+		vector<PersistentFile> fullFiles_;
+		/** \brief Charge or discharge rate file (`power_now` or `current_now`) for each device */
+		vector<PersistentFile> rateFiles_;
+		/** \brief Conversion factor from charge to energy units for each device
+		 *
+		 * Design voltage in microvolts for devices that report charge in microampere-hours, 0 if they report energy in microwatt-hours.
+		 */
+		vector<uint64_t> voltage_;
+		/** \brief Output buffer */
+		mutable string outBuffer_;
 		/** \brief Run the module once
 		 *
 		 * Retrieves the data specific to the module and formats the output.
 		 */
 		void runModule_() const override;
+		/** \brief Process kernel uevents
+		 *
+		 * Refreshes the module if any of the pending uevents come from the `power_supply` subsystem.
+		 *
+		 * \param[in] fd file descriptor
+		 * \param[in] events `epoll` events that occurred
+		 */
+		void processEvent_(const int &fd, const uint32_t &events) const override;
+		/** \brief Add a device
+		 *
+		 * Opens the attribute files of a battery or UPS device.
+		 *
+		 * \param[in] devicePath device directory
+		 */
+		void addDevice_(const string &devicePath);
 	};
 
-	/** \brief CPU status
+	/** \brief Temperature sensors
 	 *
-	 * Displays CPU temperature and load.
+	 * Reads a set of `hwmon` temperature sensors through persistent file descriptors.
+	 * Sensors are selected by chip name (the `name` attribute of the `hwmon` device, e.g. `k10temp`) and, optionally, by sensor label (e.g., `k10temp/Tctl`).
+	 * Sensors without a label are named after their attribute (e.g., `nvme/temp1`). The sensors are enumerated only when `scan()` is called, so that a reading costs one `pread` per sensor.
+	 */
+	class TemperatureSensors {
+	public:
+		/** \brief Default constructor */
+		TemperatureSensors() : summary_{Summary::first} {};
+		/** \brief Constructor
+		 *
+		 * Enumerates the selected sensors. The summary is one of `first` (the first readable sensor in the order of the selection), `max` (the hottest sensor), or `average`.
+		 * Unrecognized summaries are treated as `first`.
+		 *
+		 * \param[in] hwmonRoot `hwmon` class directory (normally `/sys/class/hwmon`)
+		 * \param[in] selection sensors to read, as chip names or chip names and labels separated by a slash; all sensors are read if empty
+		 * \param[in] summary how the readings of several sensors are combined
+		 */
+		TemperatureSensors(const string &hwmonRoot, const vector<string> &selection, const string &summary);
+		/** \brief Copy constructor (deleted) */
+		TemperatureSensors(const TemperatureSensors &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		TemperatureSensors& operator=(const TemperatureSensors &in) = delete;
+		/** \brief Destructor */
+		~TemperatureSensors() {};
+		/** \brief Enumerate the sensors
+		 *
+		 * Re-opens the selected sensors, e.g. after a `hwmon` device is added or removed.
+		 */
+		void scan();
+		/** \brief Read the temperature
+		 *
+		 * \param[out] temperature combined temperature in millidegrees Celsius, unchanged if no sensor could be read
+		 * \return `true` if at least one sensor was read
+		 */
+		bool read(int64_t &temperature) const;
+	private:
+		/** \brief Ways to combine sensor readings */
+		enum class Summary {first, max, average};
+		/** \brief `hwmon` class directory */
+		string hwmonRoot_;
+		/** \brief Selected chip names and labels */
+		vector<string> selection_;
+		/** \brief How sensor readings are combined */
+		Summary summary_;
+		/** \brief Input file of each selected sensor, in the order of the selection */
+		vector<PersistentFile> inputFiles_;
+	};
+
+	/** \brief CPU status
 	 *
+	 * Displays CPU load and temperature. The temperature is read from `hwmon` sensors, and the module listens to kernel `hwmon` uevents to find the sensors again when a device is added or removed
+	 * (e.g., when the sensor driver is loaded after the bar starts). The thermometer glyph only changes to a cooler one once the temperature has dropped a few degrees below the threshold, so that it does not flicker.
 	 */
 	class ModuleCPU final : public Module {
 	public:
 		/** \brief Default constructor */
-		ModuleCPU() : Module() {};
+		ModuleCPU() : Module(), hysteresis_{0}, ueventFD_{-1}, previousTotalLoad_{0}, previousIdleLoad_{0}, thermalLevel_{0} {};
 		/** Constructor
 		 *
 		 * \param[in] interval refresh time interval in seconds
-		 * \param[in,out] output pointer to the output storing string
-		 * \param[in,out] cVar pointer to the condition variable for change signaling
-		 * \param[in,out] sigVar pointer to the condition variable to monitor real-time signals
+		 * \param[in] hwmonRoot `hwmon` class directory (normally `/sys/class/hwmon`)
+		 * \param[in] sensors temperature sensors, as chip names or chip names and labels separated by a slash
+		 * \param[in] summary how the readings of several sensors are combined (`first`, `max`, or `average`)
+		 * \param[in] hysteresis temperature drop (in degrees Celsius) below a threshold needed to switch to a cooler glyph
+		 * \param[in,out] output pointer to the output slot
+		 * \param[in,out] trigger pointer to the render trigger for change signaling
+		 * \param[in] sigFD file descriptor that becomes readable when the real-time signal for the module arrives
 		 */
-		ModuleCPU(const uint32_t &interval, string *output, condition_variable *cVar, condition_variable *sigVar) : Module(interval, output, cVar, sigVar), previousTotalLoad_{0.0}, previousIdleLoad_{0.0} {};
+		ModuleCPU(const uint32_t &interval, const string &hwmonRoot, const vector<string> &sensors, const string &summary, const uint32_t &hysteresis,
+				OutputSlot *output, RenderTrigger *trigger, const int &sigFD);
+		/** \brief Copy constructor (deleted) */
+		ModuleCPU(const ModuleCPU &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		ModuleCPU& operator=(const ModuleCPU &in) = delete;
 		/** \brief Destructor */
-		~ModuleCPU() {};
+		~ModuleCPU();
 	protected:
-		/** \brief Previous total CPU time */
-		mutable float previousTotalLoad_;
-		/** \brief Previous idle CPU time */
-		mutable float previousIdleLoad_;
+		/** \brief Glyph hysteresis in degrees Celsius */
+		const int64_t hysteresis_;
+		/** \brief Kernel uevent socket */
+		int ueventFD_;
+		/** \brief CPU statistics file (`/proc/stat`) */
+		PersistentFile statFile_;
+		/** \brief CPU temperature sensors */
+		mutable TemperatureSensors sensors_;
+		/** \brief Previous total CPU time (in jiffies) */
+		mutable uint64_t previousTotalLoad_;
+		/** \brief Previous idle CPU time (in jiffies) */
+		mutable uint64_t previousIdleLoad_;
+		/** \brief Index of the current thermometer glyph */
+		mutable size_t thermalLevel_;
+		/** \brief Output buffer */
+		mutable string outBuffer_;
 		/** \brief Run the module once
 		 *
 		 * Retrieves the data specific to the module and formats the output.
 		 */
 		void runModule_() const override;
+		/** \brief Process kernel uevents
+		 *
+		 * Enumerates the temperature sensors again and refreshes the module if any of the pending uevents come from the `hwmon` subsystem.
+		 *
+		 * \param[in] fd file descriptor
+		 * \param[in] events `epoll` events that occurred
+		 */
+		void processEvent_(const int &fd, const uint32_t &events) const override;
 	};
-	/** \brief Free memory
+	/** \brief Per-core CPU load
 	 *
-	 * Displays the amount of free RAM.
+	 * Displays the load of every logical CPU as a block character heat map, or the busiest cores with their load.
+	 * Counters are kept in a structure-of-arrays layout, so that the per-core differences are computed in simple loops the compiler can vectorize.
+	 */
+	class ModuleCPUCores final : public Module {
+	public:
+		/** \brief Default constructor */
+		ModuleCPUCores() : Module(), nTop_{0} {};
+		/** Constructor
+		 *
+		 * \param[in] interval refresh time interval in seconds
+		 * \param[in] nTop number of the busiest cores to display; 0 displays the heat map of all cores
+		 * \param[in,out] output pointer to the output slot
+		 * \param[in,out] trigger pointer to the render trigger for change signaling
+		 * \param[in] sigFD file descriptor that becomes readable when the real-time signal for the module arrives
+		 */
+		ModuleCPUCores(const uint32_t &interval, const uint32_t &nTop, OutputSlot *output, RenderTrigger *trigger, const int &sigFD);
+		/** \brief Destructor */
+		~ModuleCPUCores() {};
+	protected:
+		/** \brief Heat map glyphs, from idle to fully loaded */
+		static const char *heatGlyphs_[];
+		/** \brief Number of heat map glyphs */
+		static const size_t nHeatGlyphs_;
+		/** \brief Number of the busiest cores to display (0 for the heat map) */
+		const uint32_t nTop_;
+		/** \brief CPU statistics file (`/proc/stat`) */
+		PersistentFile statFile_;
+		/** \brief Buffer for the CPU lines of the statistics file */
+		mutable vector<char> statBuffer_;
+		/** \brief Current idle time for each core (in jiffies) */
+		mutable vector<uint64_t> idle_;
+		/** \brief Current total time for each core (in jiffies) */
+		mutable vector<uint64_t> total_;
+		/** \brief Previous idle time for each core (in jiffies) */
+		mutable vector<uint64_t> previousIdle_;
+		/** \brief Previous total time for each core (in jiffies) */
+		mutable vector<uint64_t> previousTotal_;
+		/** \brief Load of each core in the last interval (between 0 and 1) */
+		mutable vector<float> load_;
+		/** \brief Core indexes, sorted by load for the busiest core display */
+		mutable vector<uint32_t> coreOrder_;
+		/** \brief Output buffer */
+		mutable string outBuffer_;
+		/** \brief Read the per-core counters
+		 *
+		 * \return `true` if the statistics were read
+		 */
+		bool readCounters_() const;
+		/** \brief Run the module once
+		 *
+		 * Retrieves the data specific to the module and formats the output.
+		 */
+		void runModule_() const override;
+	};
+	/** \brief Memory status
+	 *
+	 * Displays a configurable set of `/proc/meminfo` fields (e.g., available memory and free swap).
+	 * The file is read with one `pread` from a persistent file descriptor and all fields are extracted in a single scan.
 	 */
 	class ModuleRAM final : public Module {
 	public:
 		/** \brief Default constructor */
 		ModuleRAM() : Module() {};
 		/** Constructor
+		 *
+		 * Each field is a pair of strings: the `/proc/meminfo` key (e.g., `MemAvailable`) and the label to display in front of the value.
 		 *
 		 * \param[in] interval refresh time interval in seconds
-		 * \param[in,out] output pointer to the output storing string
-		 * \param[in,out] cVar pointer to the condition variable for change signaling
-		 * \param[in,out] sigVar pointer to the condition variable to monitor real-time signals
+		 * \param[in] fields fields to display
+		 * \param[in,out] output pointer to the output slot
+		 * \param[in,out] trigger pointer to the render trigger for change signaling
+		 * \param[in] sigFD file descriptor that becomes readable when the real-time signal for the module arrives
 		 */
-		ModuleRAM(const uint32_t &interval, string *output, condition_variable *cVar, condition_variable *sigVar) : Module(interval, output, cVar, sigVar) {};
+		ModuleRAM(const uint32_t &interval, const vector< vector<string> > &fields, OutputSlot *output, RenderTrigger *trigger, const int &sigFD);
 		/** \brief Destructor */
 		~ModuleRAM() {};
 	protected:
+		/** \brief Memory information file (`/proc/meminfo`) */
+		PersistentFile memInfoFile_;
+		/** \brief Keys to extract, including the trailing colon */
+		vector<string> keys_;
+		/** \brief Labels displayed in front of each value */
+		vector<string> labels_;
+		/** \brief Values of the fields in the latest scan (in KiB) */
+		mutable vector<uint64_t> values_;
+		/** \brief Whether each field was present in the latest scan */
+		mutable vector<char> found_;
+		/** \brief Output buffer */
+		mutable string outBuffer_;
+		/** \brief Run the module once
+		 *
+		 * Retrieves the data specific to the module and formats the output.
+		 */
+		void runModule_() const override;
+	};
+	/** \brief Network throughput
+	 *
+	 * Displays the receive and transmit rates of a set of network interfaces, read from `/proc/net/dev`.
+	 * Like the CPU module, it keeps the cumulative byte counters from the previous refresh and shows the differences.
+	 * The differences are taken per interface, so that a counter that wraps around or is reset (e.g., when an interface is re-created) does not produce a spike.
+	 * By default only physical interfaces (those with a `device` link in the `net` class directory) are counted, because traffic through bridges, `veth` pairs, and tunnels also passes a physical interface.
+	 */
+	class ModuleNet final : public Module {
+	public:
+		/** \brief Default constructor */
+		ModuleNet() : Module(), allInterfaces_{false} {};
+		/** Constructor
+		 *
+		 * \param[in] interval refresh time interval in seconds
+		 * \param[in] netClassRoot `net` class directory (normally `/sys/class/net`)
+		 * \param[in] interfaces interfaces to monitor; if empty, all physical interfaces are monitored
+		 * \param[in,out] output pointer to the output slot
+		 * \param[in,out] trigger pointer to the render trigger for change signaling
+		 * \param[in] sigFD file descriptor that becomes readable when the real-time signal for the module arrives
+		 */
+		ModuleNet(const uint32_t &interval, const string &netClassRoot, const vector<string> &interfaces, OutputSlot *output, RenderTrigger *trigger, const int &sigFD);
+		/** \brief Destructor */
+		~ModuleNet() {};
+	protected:
+		/** \brief Monitor all physical interfaces? */
+		const bool allInterfaces_;
+		/** \brief `net` class directory */
+		const string netClassRoot_;
+		/** \brief Network statistics file (`/proc/net/dev`) */
+		PersistentFile netDevFile_;
+		/** \brief Buffer for the statistics file */
+		mutable vector<char> netDevBuffer_;
+		/** \brief Interface names
+		 *
+		 * When all physical interfaces are monitored, interfaces are added as they appear and removed when they disappear.
+		 */
+		mutable vector<string> interfaces_;
+		/** \brief Is the traffic of each interface counted?
+		 *
+		 * Virtual interfaces found when all physical interfaces are monitored are kept, but not counted, so that they are checked only once while they exist.
+		 */
+		mutable vector<char> counted_;
+		/** \brief Previous received byte count for each interface */
+		mutable vector<uint64_t> previousRx_;
+		/** \brief Previous transmitted byte count for each interface */
+		mutable vector<uint64_t> previousTx_;
+		/** \brief Has each interface been sampled before? */
+		mutable vector<char> sampled_;
+		/** \brief Was each interface present in the latest statistics read? */
+		mutable vector<char> present_;
+		/** \brief Time of the previous refresh */
+		mutable steady_clock::time_point previousTime_;
+		/** \brief Output buffer */
+		mutable string outBuffer_;
+		/** \brief Run the module once
+		 *
+		 * Retrieves the data specific to the module and formats the output.
+		 */
+		void runModule_() const override;
+	};
+
+	/** \brief Wireless link
+	 *
+	 * Displays the SSID and signal level of a wireless interface.
+	 * The signal level is read from `/proc/net/wireless` on every refresh. The SSID is requested from the kernel over a generic netlink `nl80211` socket,
+	 * and only again when the kernel reports an association change (connection, disconnection, or roaming) on the `mlme` multicast group.
+	 */
+	class ModuleWifi final : public Module {
+	public:
+		/** \brief Signal level thresholds
+		 *
+		 * Signal levels in dBm, from strongest to weakest, that separate the signal bars.
+		 */
+		typedef const int32_t LevelTable[3];
+		/** \brief Signal bars
+		 *
+		 * Glyphs for signals stronger than the first level threshold, between the thresholds, and weaker than the last threshold.
+		 */
+		typedef const char *const BarTable[4];
+		/** \brief Default constructor */
+		ModuleWifi() : Module(), levels_{nullptr}, bars_{nullptr}, ifIndex_{0}, familyID_{0}, requestFD_{-1}, notifyFD_{-1}, sequence_{0} {};
+		/** Constructor
+		 *
+		 * \param[in] interval refresh time interval in seconds
+		 * \param[in] interface wireless interface name; if empty, the first interface in `/proc/net/wireless` is used
+		 * \param[in] levels signal level thresholds
+		 * \param[in] bars signal bar glyphs
+		 * \param[in] disconnected text displayed when there is no connection
+		 * \param[in,out] output pointer to the output slot
+		 * \param[in,out] trigger pointer to the render trigger for change signaling
+		 * \param[in] sigFD file descriptor that becomes readable when the real-time signal for the module arrives
+		 */
+		ModuleWifi(const uint32_t &interval, const string &interface, const LevelTable &levels, const BarTable &bars, const string &disconnected, OutputSlot *output, RenderTrigger *trigger, const int &sigFD);
+		/** \brief Copy constructor (deleted) */
+		ModuleWifi(const ModuleWifi &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		ModuleWifi& operator=(const ModuleWifi &in) = delete;
+		/** \brief Destructor */
+		~ModuleWifi();
+	protected:
+		/** \brief Signal level thresholds */
+		const LevelTable *levels_;
+		/** \brief Signal bar glyphs */
+		const BarTable *bars_;
+		/** \brief Text displayed when there is no connection */
+		const string disconnected_;
+		/** \brief Wireless statistics file (`/proc/net/wireless`) */
+		PersistentFile wirelessFile_;
+		/** \brief Interface name */
+		mutable string interface_;
+		/** \brief Interface index (0 if not known) */
+		mutable uint32_t ifIndex_;
+		/** \brief `nl80211` generic netlink family ID (0 if not available) */
+		uint16_t familyID_;
+		/** \brief Netlink socket for requests */
+		int requestFD_;
+		/** \brief Netlink socket subscribed to `mlme` notifications */
+		int notifyFD_;
+		/** \brief Netlink request sequence number */
+		mutable uint32_t sequence_;
+		/** \brief Current SSID (empty if not connected) */
+		mutable string ssid_;
+		/** \brief Output buffer */
+		mutable string outBuffer_;
 		/** \brief Run the module once
 		 *
 		 * Retrieves the data specific to the module and formats the output.
 		 */
 		void runModule_() const override;
+		/** \brief Process `nl80211` notifications
+		 *
+		 * Requests the SSID again and refreshes the module if any of the pending notifications is an association change on the interface.
+		 *
+		 * \param[in] fd file descriptor
+		 * \param[in] events `epoll` events that occurred
+		 */
+		void processEvent_(const int &fd, const uint32_t &events) const override;
+		/** \brief Find the interface
+		 *
+		 * Takes the first interface from `/proc/net/wireless` if none was given, and looks up the interface index.
+		 *
+		 * \return `true` if the interface index is known
+		 */
+		bool findInterface_() const;
+		/** \brief Request the SSID
+		 *
+		 * Sends an `NL80211_CMD_GET_INTERFACE` request and updates the SSID from the reply.
+		 */
+		void updateSSID_() const;
+	};
+
+	/** \brief New mail counter
+	 *
+	 * Displays the number of new messages in maildir folders.
+	 * The `new` directories of all folders with a given name are found once, when the module is constructed, and then watched with `inotify`.
+	 * Messages that arrive in or leave a `new` directory update the count as they happen, so the module needs neither a refresh interval nor an external trigger.
+	 * Running the module (e.g., with its real-time signal) counts the messages again from scratch.
+	 */
+	class ModuleMail final : public Module {
+	public:
+		/** \brief Default constructor */
+		ModuleMail() : Module(), inotifyFD_{-1} {};
+		/** Constructor
+		 *
+		 * \param[in] interval refresh time interval in seconds (normally 0, since the module is event-driven)
+		 * \param[in] mailRoot directory that holds the maildir folders; a leading `~/` is replaced with the home directory
+		 * \param[in] folderName name of the folders to watch (e.g., `Inbox`)
+		 * \param[in] glyph text appended to the message count
+		 * \param[in,out] output pointer to the output slot
+		 * \param[in,out] trigger pointer to the render trigger for change signaling
+		 * \param[in] sigFD file descriptor that becomes readable when the real-time signal for the module arrives
+		 */
+		ModuleMail(const uint32_t &interval, const string &mailRoot, const string &folderName, const string &glyph, OutputSlot *output, RenderTrigger *trigger, const int &sigFD);
+		/** \brief Copy constructor (deleted) */
+		ModuleMail(const ModuleMail &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		ModuleMail& operator=(const ModuleMail &in) = delete;
+		/** \brief Destructor */
+		~ModuleMail();
+	protected:
+		/** \brief Text appended to the message count */
+		const string glyph_;
+		/** \brief `inotify` file descriptor */
+		int inotifyFD_;
+		/** \brief `new` directory of each folder */
+		vector<string> newDirectories_;
+		/** \brief `inotify` watch descriptor of each `new` directory */
+		vector<int> watches_;
+		/** \brief Number of messages in each `new` directory */
+		mutable vector<uint32_t> counts_;
+		/** \brief Output buffer */
+		mutable string outBuffer_;
+		/** \brief Run the module once
+		 *
+		 * Counts the messages in every `new` directory and displays the total.
+		 */
+		void runModule_() const override;
+		/** \brief Process `inotify` events
+		 *
+		 * Updates the message counts and the display.
+		 *
+		 * \param[in] fd file descriptor
+		 * \param[in] events `epoll` events that occurred
+		 */
+		void processEvent_(const int &fd, const uint32_t &events) const override;
+		/** \brief Find the `new` directories
+		 *
+		 * Searches a directory tree for folders with the given name that have a `new` subdirectory.
+		 *
+		 * \param[in] directory directory to search
+		 * \param[in] folderName folder name
+		 */
+		void findFolders_(const string &directory, const string &folderName);
+		/** \brief Display the total message count */
+		void publishCount_() const;
+	};
+
+	/** \brief Pending package updates
+	 *
+	 * Displays the number of installed `pacman` packages that have newer versions in the sync databases, like `pacman -Qu`.
+	 * Installed and available versions are indexed in memory. The local database directory and the sync database directory are watched with `inotify`:
+	 * installed packages are added and removed from the index as `pacman` adds and removes their database entries, and a sync database is read again only after it is replaced (e.g., by `pacman -Sy`).
+	 * Sync databases must be gzip-compressed or uncompressed tar archives. Running the module (e.g., with its real-time signal) rebuilds the whole index.
+	 */
+	class ModulePacman final : public Module {
+	public:
+		/** \brief Default constructor */
+		ModulePacman() : Module(), inotifyFD_{-1}, localWatch_{-1}, syncWatch_{-1} {};
+		/** Constructor
+		 *
+		 * \param[in] interval refresh time interval in seconds (normally 0, since the module is event-driven)
+		 * \param[in] dbRoot `pacman` database directory (normally `/var/lib/pacman`)
+		 * \param[in] repositories sync repositories in order of priority, as in `pacman.conf`; if empty, all sync databases are used in name order
+		 * \param[in] ignored packages that are never counted (e.g., the `IgnorePkg` list from `pacman.conf`)
+		 * \param[in] glyph text appended to the update count
+		 * \param[in,out] output pointer to the output slot
+		 * \param[in,out] trigger pointer to the render trigger for change signaling
+		 * \param[in] sigFD file descriptor that becomes readable when the real-time signal for the module arrives
+		 */
+		ModulePacman(const uint32_t &interval, const string &dbRoot, const vector<string> &repositories, const vector<string> &ignored, const string &glyph,
+				OutputSlot *output, RenderTrigger *trigger, const int &sigFD);
+		/** \brief Copy constructor (deleted) */
+		ModulePacman(const ModulePacman &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		ModulePacman& operator=(const ModulePacman &in) = delete;
+		/** \brief Destructor */
+		~ModulePacman();
+	protected:
+		/** \brief Local database directory */
+		const string localPath_;
+		/** \brief Sync database directory */
+		const string syncPath_;
+		/** \brief Sync repositories in order of priority */
+		vector<string> repositories_;
+		/** \brief Packages that are never counted */
+		const vector<string> ignored_;
+		/** \brief Text appended to the update count */
+		const string glyph_;
+		/** \brief `inotify` file descriptor */
+		int inotifyFD_;
+		/** \brief `inotify` watch descriptor of the local database directory */
+		int localWatch_;
+		/** \brief `inotify` watch descriptor of the sync database directory */
+		int syncWatch_;
+		/** \brief Installed version of each package */
+		mutable unordered_map<string, string> localVersions_;
+		/** \brief Available version of each package in each sync repository */
+		mutable vector< unordered_map<string, string> > syncVersions_;
+		/** \brief Output buffer */
+		mutable string outBuffer_;
+		/** \brief Run the module once
+		 *
+		 * Rebuilds the index and displays the update count.
+		 */
+		void runModule_() const override;
+		/** \brief Process `inotify` events
+		 *
+		 * Updates the index and the display.
+		 *
+		 * \param[in] fd file descriptor
+		 * \param[in] events `epoll` events that occurred
+		 */
+		void processEvent_(const int &fd, const uint32_t &events) const override;
+		/** \brief Index the installed packages */
+		void indexLocal_() const;
+		/** \brief Index a sync repository
+		 *
+		 * \param[in] repoInd repository index
+		 */
+		void indexRepository_(const size_t &repoInd) const;
+		/** \brief Count the updates and display the count */
+		void publishCount_() const;
+	};
+
+	/** \brief File system probe
+	 *
+	 * Holds the latest `statvfs` measurement of one mount point. Measurements are made by a `MountProbePool`, which also guards the probe state.
+	 */
+	class MountProbe {
+		friend class MountProbePool;
+	public:
+		/** \brief Default constructor (deleted) */
+		MountProbe() = delete;
+		/** \brief Constructor
+		 *
+		 * \param[in] mountPoint file system mount point
+		 */
+		MountProbe(const string &mountPoint) : mountPoint_{mountPoint}, completed_{false}, success_{false}, available_{0} {};
+		/** \brief Copy constructor (deleted) */
+		MountProbe(const MountProbe &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		MountProbe& operator=(const MountProbe &in) = delete;
+		/** \brief Destructor */
+		~MountProbe() {};
+	private:
+		/** \brief Mount point */
+		const string mountPoint_;
+		/** \brief Is there a completed measurement that has not been collected yet? */
+		bool completed_;
+		/** \brief Did the latest measurement succeed? */
+		bool success_;
+		/** \brief Available space from the latest measurement (in bytes) */
+		uint64_t available_;
+	};
+
+	/** \brief File system probe workers
+	 *
+	 * Measures file systems with `statvfs` from a few worker threads fed by a request queue, so a file system that does not respond (e.g., an NFS mount whose server is down) never blocks the caller.
+	 * Workers are started as requests need them, up to a fixed maximum. A mount point has at most one measurement queued or in progress, so a hung server ties up one worker at most.
+	 * Completed measurements make an `eventfd` readable. Workers hold a shared pointer to the pool state, so that a worker stuck in `statvfs` can safely outlive the pool; it exits once it is unblocked.
+	 */
+	class MountProbePool {
+	public:
+		/** \brief Constructor */
+		MountProbePool();
+		/** \brief Copy constructor (deleted) */
+		MountProbePool(const MountProbePool &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		MountProbePool& operator=(const MountProbePool &in) = delete;
+		/** \brief Destructor
+		 *
+		 * Drops queued requests and tells the workers to exit.
+		 */
+		~MountProbePool();
+		/** \brief Completion descriptor
+		 *
+		 * \return `eventfd` that becomes readable when a measurement completes
+		 */
+		int fd() const { return state_->eventFD_; };
+		/** \brief Request a measurement
+		 *
+		 * Does not wait for the measurement. Nothing is queued if the mount point already has a measurement queued or in progress; that one completes the request.
+		 *
+		 * \param[in] probe probe to measure
+		 */
+		void request(const shared_ptr<MountProbe> &probe);
+		/** \brief Cancel a queued measurement
+		 *
+		 * A measurement that is already in progress still completes, into a probe no one reads.
+		 *
+		 * \param[in] probe probe to cancel
+		 */
+		void cancel(const shared_ptr<MountProbe> &probe);
+		/** \brief Collect a completed measurement
+		 *
+		 * \param[in] probe probe to check
+		 * \param[out] success whether the measurement succeeded
+		 * \param[out] available available space in bytes, unchanged if the measurement failed
+		 * \return `true` if a measurement completed since the last collection
+		 */
+		bool collect(const shared_ptr<MountProbe> &probe, bool &success, uint64_t &available);
+		/** \brief Reset the completion descriptor */
+		void clearCompletions();
+	private:
+		/** \brief State shared with the workers */
+		struct SharedState_ {
+			/** \brief Mutex protecting the state and the probes */
+			mutex mtx_;
+			/** \brief Condition variable signaling new requests */
+			condition_variable requestReady_;
+			/** \brief Queued measurements */
+			deque< shared_ptr<MountProbe> > queue_;
+			/** \brief Measurements in progress */
+			vector< shared_ptr<MountProbe> > active_;
+			/** \brief Number of workers */
+			size_t nWorkers_;
+			/** \brief Number of workers waiting for requests */
+			size_t nIdle_;
+			/** \brief Stop flag */
+			bool stop_;
+			/** \brief Completion `eventfd` */
+			int eventFD_;
+			/** \brief Constructor */
+			SharedState_();
+			/** \brief Destructor */
+			~SharedState_();
+		};
+		/** \brief Maximal number of workers */
+		static const size_t maxWorkers_;
+		/** \brief Pool state */
+		shared_ptr<SharedState_> state_;
+		/** \brief Worker loop
+		 *
+		 * \param[in] state pool state
+		 */
+		static void work_(shared_ptr<SharedState_> state);
 	};
+
 	/** \brief Disk free space
 	 *
-	 * Lists free space in a list of file systems in Gb and RAID status if available.
+	 * Lists free space in a list of file systems in Gb.
+	 * File systems can be listed explicitly or selected by type from the mount table.
+	 * All file systems are measured concurrently by a `MountProbePool`, and the module never waits for them: the output is published when the last file system responds or the timeout passes, whichever is first.
+	 * A file system that does not respond before the timeout shows its last measured value followed by a stale marker, which is cleared as soon as it responds.
+	 * The module watches `/proc/self/mountinfo`, which the kernel flags with `POLLPRI` when the mount table changes. File systems selected by type are added and removed as they are mounted and unmounted.
+	 * Listed file systems that are unmounted or become read-only are marked. Listed paths that are not mount points at startup take the state of the file system that holds them.
 	 */
 	class ModuleDisk final : public Module {
 	public:
 		/** \brief Default constructor */
-		ModuleDisk() : Module() {};
+		ModuleDisk() : Module(), nListed_{0}, timeout_{0}, timerFD_{-1}, measuring_{false} {};
 		/** Constructor
 		 *
 		 * \param[in] interval refresh time interval in seconds
 		 * \param[in] fsVector vector of file system names
-		 * \param[in,out] output pointer to the output storing string
-		 * \param[in,out] cVar pointer to the condition variable for change signaling
-		 * \param[in,out] sigVar pointer to the condition variable to monitor real-time signals
+		 * \param[in] fsTypes file system types (e.g., `nfs4`); every file system of these types is also listed
+		 * \param[in] timeout time to wait for the file systems to respond
+		 * \param[in] staleMarker text appended to the last good value of a file system that does not respond
+		 * \param[in] unmountedMarker text displayed instead of the value of an unmounted file system
+		 * \param[in] readOnlyMarker text appended to the value of a read-only file system
+		 * \param[in,out] output pointer to the output slot
+		 * \param[in,out] trigger pointer to the render trigger for change signaling
+		 * \param[in] sigFD file descriptor that becomes readable when the real-time signal for the module arrives
 		 */
-		ModuleDisk(const uint32_t &interval, const vector<string> &fsVector, string *output, condition_variable *cVar, condition_variable *sigVar) : Module(interval, output, cVar, sigVar), fsNames_{fsVector} {};
+		ModuleDisk(const uint32_t &interval, const vector<string> &fsVector, const vector<string> &fsTypes, const milliseconds &timeout, const string &staleMarker,
+				const string &unmountedMarker, const string &readOnlyMarker, OutputSlot *output, RenderTrigger *trigger, const int &sigFD);
+		/** \brief Copy constructor (deleted) */
+		ModuleDisk(const ModuleDisk &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		ModuleDisk& operator=(const ModuleDisk &in) = delete;
 		/** \brief Destructor */
-		~ModuleDisk() {};
+		~ModuleDisk();
 	protected:
+		/** \brief File system types selected automatically */
+		const vector<string> fsTypes_;
+		/** \brief Number of explicitly listed file systems
+		 *
+		 * They come first in the file system vectors, followed by the ones selected by type.
+		 */
+		const size_t nListed_;
+		/** \brief Time to wait for the file systems to respond */
+		const milliseconds timeout_;
+		/** \brief Stale value marker */
+		const string staleMarker_;
+		/** \brief Unmounted file system marker */
+		const string unmountedMarker_;
+		/** \brief Read-only file system marker */
+		const string readOnlyMarker_;
+		/** \brief Mount table file (`/proc/self/mountinfo`) */
+		PersistentFile mountInfoFile_;
+		/** \brief Buffer for the mount table */
+		mutable vector<char> mountInfoBuffer_;
+		/** \brief Mount points in the latest mount table */
+		mutable vector<string> mountPoints_;
+		/** \brief File system type of each mount in the latest mount table */
+		mutable vector<string> mountTypes_;
+		/** \brief Read-only state of each mount in the latest mount table */
+		mutable vector<char> mountReadOnly_;
 		/** \brief File system names */
-		vector<string> fsNames_;
+		mutable vector<string> fsNames_;
+		/** \brief Probe workers */
+		mutable MountProbePool probePool_;
+		/** \brief Timeout `timerfd` */
+		int timerFD_;
+		/** \brief Is a measurement round waiting for file systems to respond? */
+		mutable bool measuring_;
+		/** \brief Probe for each file system */
+		mutable vector< shared_ptr<MountProbe> > probes_;
+		/** \brief Last good available space for each file system (in bytes) */
+		mutable vector<uint64_t> available_;
+		/** \brief Has each file system responded since it was last mounted? */
+		mutable vector<char> measured_;
+		/** \brief Did each file system respond successfully in the current round? */
+		mutable vector<char> fresh_;
+		/** \brief Is the current round still waiting for each file system? */
+		mutable vector<char> waiting_;
+		/** \brief Is each file system a mount point that can be unmounted? */
+		mutable vector<char> tracked_;
+		/** \brief Is each file system mounted? */
+		mutable vector<char> mounted_;
+		/** \brief Is each file system read-only? */
+		mutable vector<char> readOnly_;
+		/** \brief Output buffer */
+		mutable string outBuffer_;
+		/** \brief Run the module once
+		 *
+		 * Requests measurements of all mounted file systems and starts the timeout.
+		 */
+		void runModule_() const override;
+		/** \brief Process events
+		 *
+		 * Collects completed measurements and publishes the output when the round is over or the timeout passes.
+		 * On mount table changes, re-reads the mount table, updates the file system list, and refreshes the module.
+		 *
+		 * \param[in] fd file descriptor
+		 * \param[in] events `epoll` events that occurred
+		 */
+		void processEvent_(const int &fd, const uint32_t &events) const override;
+		/** \brief Add a file system
+		 *
+		 * \param[in] fsName file system mount point or path
+		 * \param[in] tracked whether the file system is a mount point that can be unmounted
+		 */
+		void addFileSystem_(const string &fsName, const bool &tracked) const;
+		/** \brief Remove a file system
+		 *
+		 * \param[in] fsInd file system index
+		 */
+		void removeFileSystem_(const size_t &fsInd) const;
+		/** \brief Update the file system list from the latest mount table
+		 *
+		 * File systems selected by type that are no longer mounted are removed and new ones are added; the rest keep their probes and values.
+		 */
+		void updateMounts_() const;
+		/** \brief Collect completed measurements
+		 *
+		 * Publishes the output once the current round has no file systems left to wait for, or right away for a file system that responds after the round.
+		 */
+		void collectProbes_() const;
+		/** \brief Format and publish the output
+		 *
+		 * Ends the current round.
+		 */
+		void publishSpace_() const;
+	};
+	/** \brief Software RAID status
+	 *
+	 * Displays the state of every member disk of each `md` array, and the progress and speed of resync, recovery, reshape, or check operations.
+	 * The kernel signals array state changes by raising `POLLPRI` on `/proc/mdstat`, so the module refreshes as soon as an array changes (e.g., a disk fails or a resync starts).
+	 * Progress is not reported by the kernel, so while an operation runs the module also refreshes from a timer. Healthy arrays cost nothing between changes.
+	 */
+	class ModuleRAID final : public Module {
+	public:
+		/** \brief Default constructor */
+		ModuleRAID() : Module(), progressInterval_{0}, timerFD_{-1}, syncing_{false} {};
+		/** Constructor
+		 *
+		 * \param[in] interval refresh time interval in seconds (normally 0, since the module is event-driven)
+		 * \param[in] progressInterval refresh interval in seconds while an array is being synchronized
+		 * \param[in,out] output pointer to the output slot
+		 * \param[in,out] trigger pointer to the render trigger for change signaling
+		 * \param[in] sigFD file descriptor that becomes readable when the real-time signal for the module arrives
+		 */
+		ModuleRAID(const uint32_t &interval, const uint32_t &progressInterval, OutputSlot *output, RenderTrigger *trigger, const int &sigFD);
+		/** \brief Copy constructor (deleted) */
+		ModuleRAID(const ModuleRAID &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		ModuleRAID& operator=(const ModuleRAID &in) = delete;
+		/** \brief Destructor */
+		~ModuleRAID();
+	protected:
+		/** \brief Refresh interval while an array is being synchronized (in seconds) */
+		const uint32_t progressInterval_;
+		/** \brief RAID status file (`/proc/mdstat`) */
+		PersistentFile mdstatFile_;
+		/** \brief Progress timer file descriptor */
+		int timerFD_;
+		/** \brief Is an array being synchronized? */
+		mutable bool syncing_;
+		/** \brief Buffer for the RAID status file */
+		mutable vector<char> mdstatBuffer_;
+		/** \brief Output buffer */
+		mutable string outBuffer_;
 		/** \brief Run the module once
 		 *
 		 * Retrieves the data specific to the module and formats the output.
+		 * Re-reading the status file from the start also re-arms its `POLLPRI` notification.
 		 */
 		void runModule_() const override;
+		/** \brief Process status file or timer events
+		 *
+		 * \param[in] fd file descriptor
+		 * \param[in] events `epoll` events that occurred
+		 */
+		void processEvent_(const int &fd, const uint32_t &events) const override;
+	};
+	/** \brief External command
+	 *
+	 * Prepares a command for execution and starts it with its standard output connected to a pipe.
+	 * Commands without shell metacharacters are executed directly with `posix_spawnp`, without starting a shell. A leading `~/` in a word is replaced with the home directory.
+	 * Other commands are run with `/bin/sh -c`. Every command gets its own process group, so that it can be terminated together with its children.
+	 */
+	class ExternalCommand {
+	public:
+		/** \brief Default constructor */
+		ExternalCommand() {};
+		/** \brief Constructor
+		 *
+		 * \param[in] command command string
+		 */
+		ExternalCommand(const string &command);
+		/** \brief Copy constructor (deleted) */
+		ExternalCommand(const ExternalCommand &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		ExternalCommand& operator=(const ExternalCommand &in) = delete;
+		/** \brief Destructor */
+		~ExternalCommand() {};
+		/** \brief Start the command
+		 *
+		 * \param[out] readFD non-blocking read end of the output pipe
+		 * \return process ID of the command, or -1 on failure
+		 */
+		pid_t spawn(int &readFD) const;
+		/** \brief Reap a command if it has exited
+		 *
+		 * Does not wait.
+		 *
+		 * \param[in] pid process ID
+		 * \return `true` if the process exited and was reaped
+		 */
+		static bool reap(const pid_t &pid);
+		/** \brief Wait for a command to exit
+		 *
+		 * Reaps the command process if it exits before the deadline.
+		 *
+		 * \param[in] pid process ID
+		 * \param[in] deadline latest time to wait until
+		 * \return `true` if the process exited and was reaped
+		 */
+		static bool waitForExit(const pid_t &pid, const steady_clock::time_point &deadline);
+		/** \brief Terminate a command
+		 *
+		 * Sends `SIGTERM` to the command's process group, then `SIGKILL` if it has not exited after the grace period, and reaps the process.
+		 *
+		 * \param[in] pid process ID
+		 */
+		static void terminate(const pid_t &pid);
+		/** \brief Time to wait for a command to exit after `SIGTERM` before sending `SIGKILL` */
+		static const milliseconds terminateGrace_;
+	private:
+		/** \brief Characters that require a shell to interpret the command */
+		static const string shellCharacters_;
+		/** \brief Command arguments
+		 *
+		 * Either the command split into words, or a shell invocation with the whole command.
+		 */
+		vector<string> arguments_;
+		/** \brief Argument pointers for `posix_spawnp` */
+		vector<char*> argv_;
 	};
+
+	/** \brief Streaming external command
+	 *
+	 * Keeps an external command running and reads its output line by line from a non-blocking pipe.
+	 * The owner watches the pipe (`fd()`) and calls `readLine()` when it is readable. Stopping the command never blocks:
+	 * a command that has not exited right after `SIGTERM` is reaped (and killed if necessary) at the next start, or when the object is destroyed.
+	 */
+	class StreamingCommand {
+	public:
+		/** \brief Default constructor */
+		StreamingCommand() : lengthLimit_{0}, pid_{-1}, readFD_{-1}, stoppedPid_{-1} {};
+		/** \brief Constructor
+		 *
+		 * \param[in] command command string
+		 * \param[in] lengthLimit line length limit; longer lines are truncated
+		 */
+		StreamingCommand(const string &command, const size_t &lengthLimit);
+		/** \brief Copy constructor (deleted) */
+		StreamingCommand(const StreamingCommand &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		StreamingCommand& operator=(const StreamingCommand &in) = delete;
+		/** \brief Destructor
+		 *
+		 * Terminates the command.
+		 */
+		~StreamingCommand();
+		/** \brief Is the command running? */
+		bool isRunning() const { return pid_ != -1; };
+		/** \brief Read end of the output pipe (-1 if the command is not running) */
+		int fd() const { return readFD_; };
+		/** \brief Start the command
+		 *
+		 * \return `true` if the command was started; `false` if it is already running or cannot be started
+		 */
+		bool start();
+		/** \brief Stop the command
+		 *
+		 * Closes the output pipe and sends `SIGTERM` to the command's process group. The owner must stop watching the pipe first.
+		 */
+		void stop();
+		/** \brief Read the command output
+		 *
+		 * Reads all available output and extracts the last complete line. Earlier lines are discarded, since they have already been superseded.
+		 *
+		 * \param[out] line last complete line, unchanged if no line was completed
+		 * \param[out] finished set to `true` if the command closed its output; the owner should then stop the command
+		 * \return `true` if a line was completed
+		 */
+		bool readLine(string &line, bool &finished);
+	private:
+		/** \brief External command */
+		const ExternalCommand extCommand_;
+		/** \brief Line length limit */
+		const size_t lengthLimit_;
+		/** \brief Process ID of the running command (-1 if not running) */
+		pid_t pid_;
+		/** \brief Read end of the command output pipe */
+		int readFD_;
+		/** \brief Process ID of a stopped command that has not been reaped yet (-1 if none) */
+		pid_t stoppedPid_;
+		/** \brief Incomplete line read so far */
+		string lineBuffer_;
+		/** \brief Reap the stopped command
+		 *
+		 * Does not wait. A command that ignored `SIGTERM` gets `SIGKILL`.
+		 */
+		void reapStopped_();
+	};
+
 	/** \brief External scripts
 	 *
 	 * Runs an external script or shell command and displays the output.
 	 * No formatting of the external output is performed, but it is truncated to 500 characters.
+	 * The command runs without blocking the module: its output pipe and a timer for its deadline are watched descriptors, so a slow command does not hold up other modules in the event loop.
+	 * A refresh that arrives while the previous run is still going does not start the command again.
+	 * Commands that run longer than the timeout are terminated together with their children,
+	 * and the previous output is shown followed by a timeout marker.
 	 */
 	class ModuleExtern final : public Module {
 	public:
 		/** \brief Default constructor */
-		ModuleExtern() : Module() {};
+		ModuleExtern() : Module(), timeout_{0}, timerFD_{-1}, stage_{Stage::idle}, pid_{-1}, readFD_{-1}, outSize_{0}, pollInterval_{0} {};
 		/** Constructor
 		 *
 		 * \param[in] interval refresh time interval in seconds
 		 * \param[in] command external command
-		 * \param[in,out] output pointer to the output storing string
-		 * \param[in,out] cVar pointer to the condition variable for change signaling
-		 * \param[in,out] sigVar pointer to the condition variable to monitor real-time signals
+		 * \param[in] timeout maximal command run time in seconds (0 for no limit)
+		 * \param[in] timeoutMarker text appended to the previous output if the command times out
+		 * \param[in,out] output pointer to the output slot
+		 * \param[in,out] trigger pointer to the render trigger for change signaling
+		 * \param[in] sigFD file descriptor that becomes readable when the real-time signal for the module arrives
 		 */
-		ModuleExtern(const uint32_t &interval, const string &command, string *output, condition_variable *cVar, condition_variable *sigVar) : Module(interval, output, cVar, sigVar), extCommand_{command} {};
-		/** \brief Destructor */
-		~ModuleExtern() {};
+		ModuleExtern(const uint32_t &interval, const string &command, const uint32_t &timeout, const string &timeoutMarker, OutputSlot *output, RenderTrigger *trigger, const int &sigFD);
+		/** \brief Copy constructor (deleted) */
+		ModuleExtern(const ModuleExtern &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		ModuleExtern& operator=(const ModuleExtern &in) = delete;
+		/** \brief Destructor
+		 *
+		 * Terminates a command that is still running.
+		 */
+		~ModuleExtern();
 	protected:
+		/** \brief Stages of a command run */
+		enum class Stage {
+			idle,        ///< no command running
+			reading,     ///< reading the command output
+			exiting,     ///< output closed, waiting for the command to exit
+			terminating, ///< timed out, `SIGTERM` sent
+			killed       ///< `SIGKILL` sent, waiting to reap the command
+		};
 		/** \brief Output length limit */
 		static const size_t lengthLimit_;
-		/** \brief External command string */
-		const string extCommand_;
+		/** \brief Longest interval between checks for the command exit */
+		static const milliseconds maxPollInterval_;
+		/** \brief External command */
+		const ExternalCommand extCommand_;
+		/** \brief Maximal command run time in seconds */
+		const uint32_t timeout_;
+		/** \brief Marker appended to stale output */
+		const string timeoutMarker_;
+		/** \brief Timer for the run deadline and exit checks */
+		int timerFD_;
+		/** \brief Current stage of the run */
+		mutable Stage stage_;
+		/** \brief Process ID of the running command (-1 if not running) */
+		mutable pid_t pid_;
+		/** \brief Read end of the command output pipe (-1 if closed) */
+		mutable int readFD_;
+		/** \brief Number of output bytes read so far */
+		mutable size_t outSize_;
+		/** \brief End of the current stage
+		 *
+		 * The run deadline while reading or waiting for the command to exit, the end of the grace period after `SIGTERM`.
+		 */
+		mutable steady_clock::time_point stageEnd_;
+		/** \brief Current interval between checks for the command exit */
+		mutable milliseconds pollInterval_;
+		/** \brief Last output of a command that finished in time */
+		mutable string lastOutput_;
+		/** \brief Output buffer
+		 *
+		 * Allocated once and re-used for every run.
+		 */
+		mutable string outBuffer_;
+		/** \brief Run the module once
+		 *
+		 * Starts the external command, unless the previous run is still going.
+		 */
+		void runModule_() const override;
+		/** \brief Process an event on the output pipe or the timer
+		 *
+		 * \param[in] fd file descriptor
+		 * \param[in] events `epoll` events that occurred
+		 */
+		void processEvent_(const int &fd, const uint32_t &events) const override;
+		/** \brief Read the available command output
+		 *
+		 * Output past the length limit is discarded, so that the command does not block on a full pipe.
+		 */
+		void readOutput_() const;
+		/** \brief Check on the command
+		 *
+		 * Displays the output once the command exits, and moves on to `SIGTERM` and `SIGKILL` when a stage runs out of time.
+		 */
+		void checkProcess_() const;
+		/** \brief Time out the run
+		 *
+		 * Sends `SIGTERM` to the command's process group and displays the previous output with the timeout marker.
+		 */
+		void timeOut_() const;
+		/** \brief Schedule the next check
+		 *
+		 * \param[in] delay time until the timer expires; 0 disarms the timer
+		 */
+		void armTimer_(const nanoseconds &delay) const;
+		/** \brief Close the output pipe */
+		void closePipe_() const;
+	};
+
+	/** \brief Streaming external command
+	 *
+	 * Starts an external command once and keeps it running. Every line the command writes to its standard output replaces the module output.
+	 * Lines are truncated to 500 characters. If the command exits, it is started again at the next refresh (or real-time signal).
+	 */
+	class ModuleStream final : public Module {
+	public:
+		/** \brief Default constructor */
+		ModuleStream() : Module() {};
+		/** Constructor
+		 *
+		 * \param[in] interval interval in seconds between checks that the command is still running
+		 * \param[in] command external command
+		 * \param[in,out] output pointer to the output slot
+		 * \param[in,out] trigger pointer to the render trigger for change signaling
+		 * \param[in] sigFD file descriptor that becomes readable when the real-time signal for the module arrives
+		 */
+		ModuleStream(const uint32_t &interval, const string &command, OutputSlot *output, RenderTrigger *trigger, const int &sigFD);
+		/** \brief Copy constructor (deleted) */
+		ModuleStream(const ModuleStream &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		ModuleStream& operator=(const ModuleStream &in) = delete;
+		/** \brief Destructor
+		 *
+		 * Terminates the command.
+		 */
+		~ModuleStream();
+	protected:
+		/** \brief Line length limit */
+		static const size_t lengthLimit_;
+		/** \brief External command */
+		mutable StreamingCommand command_;
+		/** \brief Output buffer */
+		mutable string outBuffer_;
+		/** \brief Stop the command
+		 *
+		 * Stops watching the output pipe and stops the command.
+		 */
+		void stop_() const;
 		/** \brief Run the module once
 		 *
-		 * Runs the external shell command or script and returns the output, truncating to 500.
+		 * Starts the command if it is not running.
 		 */
 		void runModule_() const override;
+		/** \brief Process an event on the output pipe
+		 *
+		 * Reads the available output and publishes the last complete line.
+		 *
+		 * \param[in] fd file descriptor
+		 * \param[in] events `epoll` events that occurred
+		 */
+		void processEvent_(const int &fd, const uint32_t &events) const override;
+	};
+
+	/** \brief GPU status
+	 *
+	 * Displays GPU load, temperature, and clock frequency.
+	 * The values are read from `sysfs` through persistent file descriptors: the load from `gpu_busy_percent` (`amdgpu`), the temperature from the device's `hwmon` sensors,
+	 * and the frequency from the `hwmon` `freq1_input` attribute (`amdgpu`) or `gt_act_freq_mhz` (`i915`). Values the driver does not provide are left out.
+	 * For GPUs with no `sysfs` interface (e.g., the NVIDIA proprietary driver) the module instead keeps a command running that reports the values periodically, one line at a time.
+	 * Each line must start with the load in percent and the temperature in degrees Celsius, optionally followed by the frequency in MHz, separated by commas (the CSV output of `nvidia-smi --query-gpu`).
+	 */
+	class ModuleGPU final : public Module {
+	public:
+		/** \brief Default constructor */
+		ModuleGPU() : Module(), frequencyDivisor_{1}, hysteresis_{0}, thermalLevel_{0} {};
+		/** Constructor
+		 *
+		 * \param[in] interval refresh time interval in seconds (with the fallback command, the interval between checks that the command is still running)
+		 * \param[in] drmRoot DRM class directory (normally `/sys/class/drm`)
+		 * \param[in] card DRM card name (e.g., `card1`); if empty, the first card with a supported driver is used
+		 * \param[in] command fallback command for GPUs with no `sysfs` interface; the module displays nothing if empty
+		 * \param[in] hysteresis temperature drop (in degrees Celsius) below a threshold needed to switch to a cooler glyph
+		 * \param[in,out] output pointer to the output slot
+		 * \param[in,out] trigger pointer to the render trigger for change signaling
+		 * \param[in] sigFD file descriptor that becomes readable when the real-time signal for the module arrives
+		 */
+		ModuleGPU(const uint32_t &interval, const string &drmRoot, const string &card, const string &command, const uint32_t &hysteresis,
+				OutputSlot *output, RenderTrigger *trigger, const int &sigFD);
+		/** \brief Copy constructor (deleted) */
+		ModuleGPU(const ModuleGPU &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		ModuleGPU& operator=(const ModuleGPU &in) = delete;
+		/** \brief Destructor
+		 *
+		 * Terminates the fallback command.
+		 */
+		~ModuleGPU();
+	protected:
+		/** \brief Line length limit for the fallback command */
+		static const size_t lengthLimit_;
+		/** \brief Card directory, empty if no supported card was found */
+		const string cardPath_;
+		/** \brief Load file (`gpu_busy_percent`) */
+		PersistentFile busyFile_;
+		/** \brief Clock frequency file */
+		PersistentFile frequencyFile_;
+		/** \brief Divisor that converts the frequency to MHz */
+		uint64_t frequencyDivisor_;
+		/** \brief Temperature sensors of the card */
+		const TemperatureSensors sensors_;
+		/** \brief Glyph hysteresis in degrees Celsius */
+		const int64_t hysteresis_;
+		/** \brief Fallback command */
+		mutable StreamingCommand command_;
+		/** \brief Last complete line of the fallback command output */
+		mutable string line_;
+		/** \brief Index of the current thermometer glyph */
+		mutable size_t thermalLevel_;
+		/** \brief Output buffer */
+		mutable string outBuffer_;
+		/** \brief Format and display the values
+		 *
+		 * \param[in] busy load in percent, negative if unknown
+		 * \param[in] temperature temperature in degrees Celsius
+		 * \param[in] haveTemperature `true` if the temperature is known
+		 * \param[in] frequency clock frequency in MHz, 0 if unknown
+		 */
+		void publishValues_(const int64_t &busy, const int64_t &temperature, const bool &haveTemperature, const uint64_t &frequency) const;
+		/** \brief Stop the fallback command
+		 *
+		 * Stops watching the output pipe and stops the command.
+		 */
+		void stop_() const;
+		/** \brief Run the module once
+		 *
+		 * Reads the `sysfs` values, or starts the fallback command if it is not running.
+		 */
+		void runModule_() const override;
+		/** \brief Process an event on the fallback command output pipe
+		 *
+		 * Reads the available output and displays the values from the last complete line.
+		 *
+		 * \param[in] fd file descriptor
+		 * \param[in] events `epoll` events that occurred
+		 */
+		void processEvent_(const int &fd, const uint32_t &events) const override;
 	};
 }
 
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2020 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Printing to the root window (implementation)
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2020 Anthony J. Greenberg
+ * \version 0.9
+ *
+ *  Implementation of the class that keeps a connection to the X server and sets the root window name.
+ *
+ */
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <functional>
+
+#include <X11/Xlib.h>
+
+#include "renderer.hpp"
+
+using std::string;
+using std::hash;
+
+using namespace DWMBspace;
+
+bool RootRenderer::connectionLost_ = false;
+
+RootRenderer::RootRenderer() : display_{nullptr}, root_{0}, lastHash_{0} {
+	XSetIOErrorHandler(ioErrorHandler_);
+	connect_();
+}
+
+RootRenderer::~RootRenderer(){
+	disconnect_();
+}
+
+void RootRenderer::print(const string &barText){
+	const size_t textHash = hash<string>()(barText);
+	if ( (display_ != nullptr) && (textHash == lastHash_) ) {
+		return;
+	}
+	// one retry in case the server restarted since the last update
+	for (uint16_t attempt = 0; attempt < 2; ++attempt) {
+		if ( (display_ == nullptr) && !connect_() ) {
+			return;         // fail silently
+		}
+		XStoreName( display_, root_, barText.c_str() );
+		XFlush(display_);
+		if (connectionLost_) {
+			disconnect_();
+			continue;
+		}
+		lastHash_ = textHash;
+		return;
+	}
+}
+
+bool RootRenderer::connect_(){
+	display_ = XOpenDisplay(NULL);
+	if (display_ == nullptr) {
+		return false;
+	}
+	connectionLost_ = false;
+	XSetIOErrorExitHandler(display_, ioErrorExitHandler_, nullptr);
+	root_ = RootWindow( display_, DefaultScreen(display_) );
+	lastHash_ = 0;
+	return true;
+}
+
+void RootRenderer::disconnect_(){
+	if (display_ != nullptr) {
+		XCloseDisplay(display_);
+		display_ = nullptr;
+	}
+}
+
+int RootRenderer::ioErrorHandler_(Display *display){
+	return 0;
+}
+
+void RootRenderer::ioErrorExitHandler_(Display *display, void *userData){
+	connectionLost_ = true;
+}
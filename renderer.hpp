@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2020 Anthony J. Greenberg
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/// Printing to the root window (definitions)
+/** \file
+ * \author Anthony J. Greenberg
+ * \copyright Copyright (c) 2020 Anthony J. Greenberg
+ * \version 0.9
+ *
+ *  Definition of the class that keeps a connection to the X server and sets the root window name.
+ *
+ */
+#ifndef renderer_hpp
+#define renderer_hpp
+
+#include <cstddef>
+#include <string>
+
+#include <X11/Xlib.h>
+
+using std::string;
+
+namespace DWMBspace {
+
+	/** \brief Root window renderer
+	 *
+	 * Keeps the X display connection and the root window handle open between bar updates.
+	 * dwm reads the status text from the root window name (the `WM_NAME` property).
+	 * If the X server goes away, the connection is re-established on the next update.
+	 */
+	class RootRenderer {
+	public:
+		/** \brief Default constructor
+		 *
+		 * Opens the display. Failure to connect is silent; connection is attempted again on the next update.
+		 */
+		RootRenderer();
+		/** \brief Copy constructor (deleted) */
+		RootRenderer(const RootRenderer &in) = delete;
+		/** \brief Copy assignment (deleted) */
+		RootRenderer& operator=(const RootRenderer &in) = delete;
+		/** \brief Destructor */
+		~RootRenderer();
+		/** \brief Render the bar
+		 *
+		 * Sets the root window name to the provided text and flushes the request to the server.
+		 * Nothing is sent if the hash of the text is the same as that from the previous successful update.
+		 *
+		 * \param[in] barText text to be displayed
+		 */
+		void print(const string &barText);
+	private:
+		/** \brief X display */
+		Display *display_;
+		/** \brief Root window */
+		Window root_;
+		/** \brief Hash of the text sent in the last update */
+		size_t lastHash_;
+		/** \brief Connection lost flag
+		 *
+		 * Set by the Xlib I/O error handler when the server connection breaks.
+		 */
+		static bool connectionLost_;
+		/** \brief Connect to the X server
+		 *
+		 * \return `true` if the connection succeeded
+		 */
+		bool connect_();
+		/** \brief Close the connection to the X server */
+		void disconnect_();
+		/** \brief Xlib I/O error handler
+		 *
+		 * Prevents Xlib from printing an error message.
+		 *
+		 * \param[in] display X display
+		 * \return always 0
+		 */
+		static int ioErrorHandler_(Display *display);
+		/** \brief Xlib I/O error exit handler
+		 *
+		 * Flags the lost connection instead of terminating the program.
+		 *
+		 * \param[in] display X display
+		 * \param[in] userData unused
+		 */
+		static void ioErrorExitHandler_(Display *display, void *userData);
+	};
+}
+
+#endif // renderer_hpp